@@ -0,0 +1,112 @@
+#include "pool_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <malloc.h>
+#include <map>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// resident set size in KiB (second field of /proc/self/statm, in pages)
+long rssKiB() {
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Each workload stores the process RSS at the point where its container is
+// largest into `full`, and destroys the container on return.
+
+// shared_list from the mutex examples: append, and consume from the front
+template<template<class> class Alloc>
+void listWorkload(int n, long& full) {
+    list<string, Alloc<string>> shared_list;
+    for (int i = 0; i < n; ++i) shared_list.push_back("step " + to_string(i));
+    for (int i = 0; i < n; ++i) {
+        shared_list.pop_front();
+        shared_list.push_back("step " + to_string(i));
+    }
+    full = rssKiB();
+}
+
+// map<string,int> from map.cpp: insert, erase half, insert again
+template<template<class> class Alloc>
+void mapWorkload(int n, long& full) {
+    map<string, int, less<string>, Alloc<pair<const string, int>>> map1;
+    mt19937 rng(1);
+    for (int i = 0; i < n; ++i) map1["k" + to_string(rng() % (4 * n))] = i;
+    for (auto it = map1.begin(); it != map1.end();) it = (it->second % 2) ? map1.erase(it) : next(it);
+    for (int i = 0; i < n; ++i) map1.emplace("k" + to_string(rng() % (4 * n)), i);
+    full = rssKiB();
+}
+
+template<template<class> class Alloc>
+void unorderedMapWorkload(int n, long& full) {
+    unordered_map<int, int, hash<int>, equal_to<int>, Alloc<pair<const int, int>>> umap;
+    mt19937 rng(2);
+    for (int i = 0; i < n; ++i) umap[int(rng())] = i;
+    for (auto it = umap.begin(); it != umap.end();) it = (it->second % 2) ? umap.erase(it) : next(it);
+    for (int i = 0; i < n; ++i) umap.emplace(int(rng()), i);
+    full = rssKiB();
+}
+
+// Run `workload` on `threads` threads, each with its own container, in a
+// fresh child process so that the RSS numbers do not see earlier runs
+template<class Workload>
+void measure(const char* name, int n, int threads, Workload workload) {
+    cout.flush();
+    pid_t pid = fork();
+    if (pid != 0) {
+        waitpid(pid, nullptr, 0);
+        return;
+    }
+    long before = rssKiB();
+    vector<long> full(threads);
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back([&, t] { workload(n, full[t]); });
+    workload(n, full[0]);
+    for (auto& th : pool) th.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long after = rssKiB();
+    // hand free memory back to the system: the pool's cached slabs, and malloc's free pages
+    pool::SlabDepot::trim();
+    malloc_trim(0);
+    printf("%-34s %6.2f Mops/s   RSS full +%7ld KiB, after destroy +%7ld KiB, after trim +%7ld KiB\n", name,
+           3.0 * n * threads / seconds / 1e6, *max_element(full.begin(), full.end()) - before, after - before,
+           rssKiB() - before);
+    fflush(stdout);
+    _exit(0);
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 500000;
+
+    // 1 the allocator plugs into the standard containers as the last template argument
+    list<string, pool::PoolAllocator<string>> shared_list{"a", "b"};
+    map<string, int, less<string>, pool::PoolAllocator<pair<const string, int>>> map1{{"abc", 300}, {"b", 100}};
+    cout << shared_list.size() << " list nodes, " << map1["abc"] << endl;
+
+    // 2 throughput: n inserts + n erase/insert pairs per thread
+    for (int threads : {1, 4}) {
+        cout << "\n" << threads << " thread(s), " << n << " elements per container" << endl;
+        measure("list<string>      std::allocator", n, threads, listWorkload<allocator>);
+        measure("list<string>      PoolAllocator ", n, threads, listWorkload<pool::PoolAllocator>);
+        measure("map<string,int>   std::allocator", n, threads, mapWorkload<allocator>);
+        measure("map<string,int>   PoolAllocator ", n, threads, mapWorkload<pool::PoolAllocator>);
+        measure("unordered_map     std::allocator", n, threads, unorderedMapWorkload<allocator>);
+        measure("unordered_map     PoolAllocator ", n, threads, unorderedMapWorkload<pool::PoolAllocator>);
+    }
+    return 0;
+}
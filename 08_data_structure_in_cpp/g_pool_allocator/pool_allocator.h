@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace pool {
+
+// Process-wide source of fixed-size slabs. Every thread keeps a small cache
+// of free slabs, so arenas on different threads rarely touch the shared list
+// (and its mutex); only an empty global list falls back to malloc.
+class SlabDepot {
+public:
+    static constexpr std::size_t kSlabSize = 64 * 1024;
+
+    static void* acquire() {
+        Cache* cache = threadCache();
+        if (cache && cache->count > 0) return cache->slabs[--cache->count];
+        {
+            std::lock_guard<std::mutex> lock(global().mutex);
+            if (FreeSlab* slab = global().head) {
+                global().head = slab->next;
+                --global().count;
+                return slab;
+            }
+        }
+        void* slab = std::malloc(kSlabSize);
+        if (!slab) throw std::bad_alloc();
+        return slab;
+    }
+
+    static void release(void* slab) noexcept {
+        Cache* cache = threadCache();
+        if (cache && cache->count < kCacheSlabs) {
+            cache->slabs[cache->count++] = slab;
+            return;
+        }
+        pushGlobal(slab);
+    }
+
+    // Give the slabs of the shared list back to the system; returns how many
+    static std::size_t trim() noexcept {
+        std::lock_guard<std::mutex> lock(global().mutex);
+        std::size_t n = global().count;
+        while (FreeSlab* slab = global().head) {
+            global().head = slab->next;
+            std::free(slab);
+        }
+        global().count = 0;
+        return n;
+    }
+
+private:
+    static constexpr int kCacheSlabs = 16;
+
+    struct FreeSlab {
+        FreeSlab* next;
+    };
+    struct Global {
+        std::mutex mutex;
+        FreeSlab* head = nullptr;
+        std::size_t count = 0;
+    };
+    struct Cache {
+        void* slabs[kCacheSlabs];
+        int count = 0;
+        ~Cache() {
+            cacheGone() = true;
+            while (count > 0) pushGlobal(slabs[--count]);
+        }
+    };
+
+    // Leaked on purpose: a static container's arena can die after every
+    // function-local static, and must still find the list and its mutex
+    static Global& global() {
+        static Global* instance = new Global;
+        return *instance;
+    }
+    // Arenas can die after their thread's cache (e.g. a static container),
+    // those go straight to the global list
+    static bool& cacheGone() {
+        thread_local bool gone = false;
+        return gone;
+    }
+    static Cache* threadCache() {
+        if (cacheGone()) return nullptr;
+        thread_local Cache cache;
+        return &cache;
+    }
+    static void pushGlobal(void* slab) noexcept {
+        std::lock_guard<std::mutex> lock(global().mutex);
+        FreeSlab* node = static_cast<FreeSlab*>(slab);
+        node->next = global().head;
+        global().head = node;
+        ++global().count;
+    }
+};
+
+// Nodes of one container: bump allocation out of slabs, one free list per
+// size class (multiples of 16 bytes). The destructor hands whole slabs back
+// to the depot. An arena is usually used by one container, but allocator
+// copies must compare equal, so after a move (or a swap, or a propagating
+// assignment) two containers can share it and run on different threads:
+// every call takes the arena's mutex, which is uncontended in the common case.
+class Arena {
+public:
+    static constexpr std::size_t kGranule = 16;
+    static constexpr std::size_t kMaxNode = 512;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        while (slabs) {
+            char* next = *reinterpret_cast<char**>(slabs);
+            SlabDepot::release(slabs);
+            slabs = next;
+        }
+    }
+
+    void* allocate(std::size_t bytes) {
+        std::size_t sizeClass = (bytes + kGranule - 1) / kGranule;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (FreeNode* node = freeLists[sizeClass]) {
+            freeLists[sizeClass] = node->next;
+            return node;
+        }
+        std::size_t size = sizeClass * kGranule;
+        if (cursor == nullptr || size > std::size_t(end - cursor)) newSlab();
+        void* p = cursor;
+        cursor += size;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t bytes) noexcept {
+        std::size_t sizeClass = (bytes + kGranule - 1) / kGranule;
+        FreeNode* node = static_cast<FreeNode*>(p);
+        std::lock_guard<std::mutex> lock(mutex);
+        node->next = freeLists[sizeClass];
+        freeLists[sizeClass] = node;
+    }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    // the first granule of each slab links it to the previously acquired one
+    void newSlab() {
+        char* slab = static_cast<char*>(SlabDepot::acquire());
+        *reinterpret_cast<char**>(slab) = slabs;
+        slabs = slab;
+        cursor = slab + kGranule;
+        end = slab + SlabDepot::kSlabSize;
+    }
+
+    std::mutex mutex;
+    FreeNode* freeLists[kMaxNode / kGranule + 1] = {};
+    char* slabs = nullptr;
+    char* cursor = nullptr;
+    char* end = nullptr;
+};
+
+// Standard allocator for node-based containers (std::list, std::map,
+// std::unordered_map, ...). A container's allocator and all its rebound
+// copies share one Arena; when the container is destroyed, the arena goes
+// with it and returns its slabs in bulk. Single-object requests up to
+// Arena::kMaxNode bytes come from the arena, anything else (e.g. the bucket
+// array of an unordered_map) from std::allocator.
+template<class T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    PoolAllocator() : arena(std::make_shared<Arena>()) {}
+    PoolAllocator(const PoolAllocator&) noexcept = default;
+    PoolAllocator& operator=(const PoolAllocator&) noexcept = default;
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    // a copied container gets its own arena
+    PoolAllocator select_on_container_copy_construction() const { return PoolAllocator(); }
+
+    T* allocate(std::size_t n) {
+        if (fromArena(n)) return static_cast<T*>(arena->allocate(sizeof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (fromArena(n))
+            arena->deallocate(p, sizeof(T));
+        else
+            std::allocator<T>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template<class U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+private:
+    template<class U>
+    friend class PoolAllocator;
+
+    static constexpr bool fromArena(std::size_t n) {
+        return n == 1 && sizeof(T) <= Arena::kMaxNode && alignof(T) <= Arena::kGranule;
+    }
+
+    std::shared_ptr<Arena> arena;
+};
+
+} // namespace pool
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Allocation profiler. Linking src/allocation_profiler.cpp into a program
+// replaces the global operator new/delete (all forms). Programs that do not
+// link it are not affected.
+//
+// - totals (count, bytes, live and peak bytes) are exact,
+// - call stacks are sampled by bytes: about one allocation per `period` bytes
+//   a thread allocates records its stack in a thread-local table, weighted
+//   so that the per-stack counts and bytes in the report are unbiased estimates,
+// - the report is printed to stderr at exit, or on demand with report().
+namespace alloc_prof {
+
+struct Totals {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t liveBytes = 0;
+    uint64_t peakBytes = 0;
+};
+
+// Sum over all threads, including threads that already exited
+Totals totals();
+
+// Sampling period in bytes. 1 records the stack of every allocation (exact,
+// slow); the default 16 KiB can also be set with the environment variable
+// ALLOC_PROF_SAMPLE
+void setSamplePeriod(std::size_t bytes);
+
+// Totals plus the `topSites` call stacks with the most bytes
+void report(std::FILE* out = stderr, std::size_t topSites = 10);
+
+// Counts the allocations the current thread makes while the guard is alive.
+// Policy::Report prints them when the guard ends, Policy::Abort also aborts:
+// use it to keep hot regions allocation-free.
+class AllocationGuard {
+public:
+    enum class Policy { Report, Abort };
+
+    explicit AllocationGuard(const char* name, Policy policy = Policy::Report);
+    ~AllocationGuard();
+
+    AllocationGuard(const AllocationGuard&) = delete;
+    AllocationGuard& operator=(const AllocationGuard&) = delete;
+
+    uint64_t allocations() const;  // so far
+    uint64_t bytes() const;
+
+private:
+    const char* name;
+    Policy policy;
+    uint64_t startAllocations;
+    uint64_t startBytes;
+};
+
+} // namespace alloc_prof
@@ -0,0 +1,89 @@
+#include "allocation_profiler.h"
+
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using alloc_prof::AllocationGuard;
+
+// csv2Dvector from a_file_IO: one vector per row, one string per field
+std::vector<std::vector<double>> csv2Dvector(std::istream& input) {
+    std::vector<std::vector<double>> data;
+    std::string s;
+    while (std::getline(input, s)) {
+        std::istringstream ss(s);
+        std::vector<double> record;
+        std::string field;
+        while (std::getline(ss, field, ','))
+            record.push_back(std::stod(field));
+        data.push_back(record);
+    }
+    return data;
+}
+
+// The same parse into one flat vector: buffers are reused, strtod needs no string
+std::vector<double> csvFlat(const std::string& text, size_t expectedValues) {
+    std::vector<double> data;
+    data.reserve(expectedValues);
+    const char* p = text.c_str();
+    while (*p) {
+        char* end;
+        data.push_back(std::strtod(p, &end));
+        p = *end ? end + 1 : end;
+    }
+    return data;
+}
+
+// The task queue of d_thread_pool: a lambda that captures more than
+// std::function's small buffer is copied to the heap on every enqueue
+void taskQueue(int tasks) {
+    std::queue<std::function<void()>> queue;
+    double sum = 0;
+    for (int i = 0; i < tasks; ++i) {
+        double a = i, b = i, c = i;
+        queue.emplace([&sum, a, b, c] { sum += a + b + c; });
+    }
+    while (!queue.empty()) {
+        queue.front()();
+        queue.pop();
+    }
+    std::cout << "taskQueue sum " << sum << '\n';
+}
+
+int main() {
+    std::string csv;
+    for (int row = 0; row < 10000; ++row)
+        csv += "64.529999,64.800003,64.139999,64.620003,21705200,64.620003\n";
+
+    {
+        AllocationGuard guard("csv2Dvector");
+        std::istringstream input(csv);
+        auto rows = csv2Dvector(input);
+        std::cout << "csv2Dvector: " << rows.size() << " rows\n";
+    }
+    {
+        AllocationGuard guard("csvFlat");
+        auto values = csvFlat(csv, 6 * 10000);
+        std::cout << "csvFlat: " << values.size() << " values\n";
+    }
+
+    // allocations on other threads are recorded in their own buffers
+    std::thread worker(taskQueue, 20000);
+    worker.join();
+
+    // a hot loop that must not allocate: Policy::Abort turns a regression into a crash
+    std::vector<double> buffer(1024);
+    {
+        AllocationGuard guard("hot loop", AllocationGuard::Policy::Abort);
+        for (int round = 0; round < 1000; ++round)
+            for (auto& v : buffer) v = v * 0.5 + round;
+    }
+
+    auto t = alloc_prof::totals();
+    std::cout << "so far: " << t.allocations << " allocations, peak " << t.peakBytes << " bytes\n\n";
+    // the full report with call stacks is printed at exit
+}
@@ -0,0 +1,427 @@
+#include "allocation_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace alloc_prof {
+namespace {
+
+constexpr int kMaxFrames = 16;
+constexpr int kPrintFrames = 6;
+constexpr size_t kSites = 1024;  // call stacks per thread
+constexpr size_t kProbes = 32;
+
+// One distinct call stack. Only the owning thread writes it; `key` is
+// published last (release), so a reader that sees the key sees the frames.
+struct Site {
+    std::atomic<uint64_t> key{0};  // hash of the frames, 0 = empty slot
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+    int depth = 0;
+    void* frames[kMaxFrames];
+};
+
+// Per-thread counters and call-stack table. Allocated with calloc and never
+// freed, so the counts of exited threads still show up in the report. When a
+// thread exits, its record goes onto a free list and the next new thread
+// carries on counting in it, so the number of records is bounded by the
+// number of threads alive at the same time.
+struct ThreadRecord {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> lostSamples{0};  // call-stack table was full
+    uint64_t untilSample = 0;  // bytes left until the next sample point
+    uint64_t rng = 0;          // xorshift state for the sample gaps
+    bool busy = false;         // inside the profiler itself: do not sample
+    ThreadRecord* next = nullptr;
+    ThreadRecord* nextFree = nullptr;
+    Site sites[kSites];
+};
+
+std::atomic<ThreadRecord*> records{nullptr};
+std::atomic<int64_t> liveBytes{0};
+std::atomic<int64_t> peakBytes{0};
+std::atomic<uint64_t> samplePeriod{16 * 1024};
+
+// Records of exited threads. Only touched when a thread starts or exits,
+// so a spin lock is enough (and it needs no allocation and no destructor).
+std::atomic_flag freeLock = ATOMIC_FLAG_INIT;
+ThreadRecord* freeRecords = nullptr;
+
+// After its record was handed back, an exiting thread can still allocate
+// (destructors of thread_locals constructed before the record). Those
+// allocations are counted here, without call stacks.
+std::atomic<uint64_t> lateAllocations{0};
+std::atomic<uint64_t> lateFrees{0};
+std::atomic<uint64_t> lateBytes{0};
+
+thread_local ThreadRecord* self = nullptr;
+thread_local bool released = false;
+
+// Single writer per counter: a relaxed load + store, no read-modify-write
+void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+ThreadRecord* acquireRecord() {
+    while (freeLock.test_and_set(std::memory_order_acquire)) {}
+    ThreadRecord* r = freeRecords;
+    if (r) freeRecords = r->nextFree;
+    freeLock.clear(std::memory_order_release);
+    if (r) return r;
+
+    void* memory = std::calloc(1, sizeof(ThreadRecord));
+    if (!memory) std::abort();
+    r = new (memory) ThreadRecord;
+    r->rng = reinterpret_cast<uintptr_t>(r) | 1;
+    r->untilSample = samplePeriod.load(std::memory_order_relaxed);
+    ThreadRecord* head = records.load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    return r;
+}
+
+// Hands the record back when the thread exits
+struct ReleaseAtExit {
+    ~ReleaseAtExit() {
+        released = true;
+        ThreadRecord* r = std::exchange(self, nullptr);
+        while (freeLock.test_and_set(std::memory_order_acquire)) {}
+        r->nextFree = freeRecords;
+        freeRecords = r;
+        freeLock.clear(std::memory_order_release);
+    }
+};
+
+// nullptr once the thread has started to exit
+ThreadRecord* thisThread() {
+    if (!self && !released) {
+        self = acquireRecord();
+        // registered with __cxa_thread_atexit, which uses calloc, not operator new
+        thread_local ReleaseAtExit releaseAtExit;
+        (void)releaseAtExit;
+    }
+    return self;
+}
+
+// Record the call stack above `caller` (the return address of operator new)
+// Uniform in [1, 2 * period - 1], so the mean is `period` (exactly 1 for period 1)
+uint64_t nextGap(ThreadRecord& r, uint64_t period) {
+    r.rng ^= r.rng << 13;
+    r.rng ^= r.rng >> 7;
+    r.rng ^= r.rng << 17;
+    return 1 + r.rng % (2 * period - 1);
+}
+
+// `points` sample points fell into this allocation of `size` bytes
+void sample(ThreadRecord& r, std::size_t size, uint64_t points, void* caller) {
+    r.busy = true;
+    void* frames[kMaxFrames + 8];
+    int depth = backtrace(frames, kMaxFrames + 8);
+    // drop the profiler's own frames; their number depends on inlining
+    int first = 0;
+    for (int i = 0; i < depth; ++i)
+        if (static_cast<char*>(frames[i]) == static_cast<char*>(caller)) {
+            first = i;
+            break;
+        }
+    depth = std::min(depth - first, kMaxFrames);
+
+    uint64_t key = 1469598103934665603ull;  // FNV-1a over the frame addresses
+    for (int i = 0; i < depth; ++i)
+        key = (key ^ reinterpret_cast<uintptr_t>(frames[first + i])) * 1099511628211ull;
+    key = key ? key : 1;
+
+    // Every sample point stands for `period` bytes, so an allocation is
+    // counted with about max(size, period) bytes, and on average with its
+    // true size. The allocation count is derived from the same weight.
+    uint64_t period = samplePeriod.load(std::memory_order_relaxed);
+    uint64_t weightBytes = points * period;
+    uint64_t weightCount = std::max<uint64_t>(1, (weightBytes + size / 2) / size);
+    for (size_t probe = 0; probe < kProbes; ++probe) {
+        Site& site = r.sites[(key + probe) % kSites];
+        uint64_t current = site.key.load(std::memory_order_relaxed);
+        if (current == 0) {
+            site.depth = depth;
+            std::memcpy(site.frames, frames + first, depth * sizeof(void*));
+            site.key.store(key, std::memory_order_release);
+            current = key;
+        }
+        if (current == key) {
+            bump(site.count, weightCount);
+            bump(site.bytes, weightBytes);
+            r.busy = false;
+            return;
+        }
+    }
+    bump(r.lostSamples, 1);
+    r.busy = false;
+}
+
+void recordAllocation(std::size_t size, void* caller) {
+    int64_t live = liveBytes.fetch_add(int64_t(size), std::memory_order_relaxed) + int64_t(size);
+    int64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    ThreadRecord* r = thisThread();
+    if (!r) {
+        lateAllocations.fetch_add(1, std::memory_order_relaxed);
+        lateBytes.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+    bump(r->allocations, 1);
+    bump(r->bytes, size);
+    if (r->busy) return;
+    // Sample by bytes: sample points lie a random distance apart, `period`
+    // bytes on average (random, so that regular allocation patterns cannot
+    // line up with them), and an allocation is sampled if one falls into it
+    uint64_t bytes = std::max<uint64_t>(size, 1);
+    if (bytes < r->untilSample) {
+        r->untilSample -= bytes;
+        return;
+    }
+    uint64_t period = samplePeriod.load(std::memory_order_relaxed);
+    uint64_t left = bytes - r->untilSample, points = 1;
+    if (left >= period) {  // large block: about one point per period
+        points += left / period;
+        r->untilSample = nextGap(*r, period);
+    } else {
+        r->untilSample = nextGap(*r, period);
+        for (; left >= r->untilSample; ++points) {
+            left -= r->untilSample;
+            r->untilSample = nextGap(*r, period);
+        }
+        r->untilSample -= left;
+    }
+    sample(*r, bytes, points, caller);
+}
+
+// Every block carries its size (for live bytes) and the distance back to
+// the start of the malloc'd memory, right in front of the user pointer.
+struct Header {
+    std::size_t size;
+    std::size_t offset;
+};
+
+void* allocateOrNull(std::size_t size, std::size_t align, void* caller) {
+    std::size_t offset = std::max(align, sizeof(Header));
+    // size + offset, rounded up to `align`, must not wrap around
+    if (size > SIZE_MAX - offset - align) return nullptr;
+    void* raw;
+    if (align <= alignof(std::max_align_t))
+        raw = std::malloc(size + offset);
+    else
+        raw = std::aligned_alloc(align, (size + offset + align - 1) / align * align);
+    if (!raw) return nullptr;
+    char* user = static_cast<char*>(raw) + offset;
+    Header* header = reinterpret_cast<Header*>(user - sizeof(Header));
+    header->size = size;
+    header->offset = offset;
+    recordAllocation(size, caller);
+    return user;
+}
+
+void* allocate(std::size_t size, std::size_t align, void* caller) {
+    for (;;) {
+        if (void* p = allocateOrNull(size, align, caller)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void deallocate(void* p) noexcept {
+    if (!p) return;
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(p) - sizeof(Header));
+    std::size_t size = header->size;
+    char* raw = static_cast<char*>(p) - header->offset;
+    if (ThreadRecord* r = thisThread())
+        bump(r->frees, 1);
+    else
+        lateFrees.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+    std::free(raw);
+}
+
+void printFrame(std::FILE* out, const char* symbol) {
+    // glibc format: "binary(mangled+0x1f) [0x4011aa]"
+    // the offset is kept for addr2line
+    const char* open = std::strchr(symbol, '(');
+    const char* plus = open ? std::strchr(open, '+') : nullptr;
+    const char* close = plus ? std::strchr(plus, ')') : nullptr;
+    if (open && plus && close && plus > open + 1) {
+        std::string mangled(open + 1, plus), offset(plus, close);
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+        std::fprintf(out, "        %s%s\n", status == 0 ? demangled : mangled.c_str(), offset.c_str());
+        std::free(demangled);
+    } else {
+        std::fprintf(out, "        %s\n", symbol);
+    }
+}
+
+struct Startup {
+    Startup() {
+        if (const char* period = std::getenv("ALLOC_PROF_SAMPLE")) setSamplePeriod(std::strtoull(period, nullptr, 10));
+    }
+    ~Startup() { report(stderr); }
+} startup;
+
+} // namespace
+
+Totals totals() {
+    Totals t;
+    for (ThreadRecord* r = records.load(std::memory_order_acquire); r; r = r->next) {
+        t.allocations += r->allocations.load(std::memory_order_relaxed);
+        t.frees += r->frees.load(std::memory_order_relaxed);
+        t.bytesAllocated += r->bytes.load(std::memory_order_relaxed);
+    }
+    t.allocations += lateAllocations.load(std::memory_order_relaxed);
+    t.frees += lateFrees.load(std::memory_order_relaxed);
+    t.bytesAllocated += lateBytes.load(std::memory_order_relaxed);
+    t.liveBytes = uint64_t(std::max<int64_t>(0, liveBytes.load(std::memory_order_relaxed)));
+    t.peakBytes = uint64_t(peakBytes.load(std::memory_order_relaxed));
+    return t;
+}
+
+void setSamplePeriod(std::size_t bytes) {
+    samplePeriod.store(std::max<std::size_t>(1, bytes), std::memory_order_relaxed);
+}
+
+void report(std::FILE* out, std::size_t topSites) {
+    ThreadRecord* me = thisThread();  // nullptr at exit: the main thread's record is already released
+    bool wasBusy = me && me->busy;
+    if (me) me->busy = true;  // the vectors and strings below allocate too
+
+    Totals t = totals();
+    std::fprintf(out, "[alloc-prof] %llu allocations, %llu frees, %llu bytes allocated\n",
+                 (unsigned long long)t.allocations, (unsigned long long)t.frees,
+                 (unsigned long long)t.bytesAllocated);
+    std::fprintf(out, "[alloc-prof] peak live %llu bytes, live now %llu bytes in %llu blocks\n",
+                 (unsigned long long)t.peakBytes, (unsigned long long)t.liveBytes,
+                 (unsigned long long)(t.allocations - t.frees));
+
+    struct Merged {
+        uint64_t key, count, bytes;
+        const Site* site;
+    };
+    std::vector<Merged> merged;
+    uint64_t lost = 0;
+    for (ThreadRecord* r = records.load(std::memory_order_acquire); r; r = r->next) {
+        lost += r->lostSamples.load(std::memory_order_relaxed);
+        for (const Site& site : r->sites)
+            if (uint64_t key = site.key.load(std::memory_order_acquire))
+                merged.push_back({key, site.count.load(std::memory_order_relaxed),
+                                  site.bytes.load(std::memory_order_relaxed), &site});
+    }
+    // the same call stack seen by several threads is one site
+    std::sort(merged.begin(), merged.end(), [](const Merged& a, const Merged& b) { return a.key < b.key; });
+    std::vector<Merged> sites;
+    for (const Merged& m : merged) {
+        if (!sites.empty() && sites.back().key == m.key) {
+            sites.back().count += m.count;
+            sites.back().bytes += m.bytes;
+        } else {
+            sites.push_back(m);
+        }
+    }
+    std::sort(sites.begin(), sites.end(), [](const Merged& a, const Merged& b) { return a.bytes > b.bytes; });
+
+    std::fprintf(out, "[alloc-prof] top call stacks by bytes (one sample per %llu bytes, estimates):\n",
+                 (unsigned long long)samplePeriod.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < std::min(topSites, sites.size()); ++i) {
+        const Site& site = *sites[i].site;
+        std::fprintf(out, "  #%zu  ~%llu allocations, ~%llu bytes\n", i + 1,
+                     (unsigned long long)sites[i].count, (unsigned long long)sites[i].bytes);
+        int depth = std::min(site.depth, kPrintFrames);
+        char** symbols = backtrace_symbols(const_cast<void* const*>(site.frames), depth);
+        for (int f = 0; symbols && f < depth; ++f) printFrame(out, symbols[f]);
+        std::free(symbols);
+    }
+    if (lost) std::fprintf(out, "[alloc-prof] %llu samples lost (call-stack table full)\n", (unsigned long long)lost);
+    if (me) me->busy = wasBusy;
+}
+
+namespace {
+// the calling thread's counters; an exiting thread has none left
+uint64_t threadAllocations() {
+    ThreadRecord* r = thisThread();
+    return r ? r->allocations.load(std::memory_order_relaxed) : 0;
+}
+uint64_t threadBytes() {
+    ThreadRecord* r = thisThread();
+    return r ? r->bytes.load(std::memory_order_relaxed) : 0;
+}
+} // namespace
+
+AllocationGuard::AllocationGuard(const char* name, Policy policy)
+    : name(name), policy(policy), startAllocations(threadAllocations()), startBytes(threadBytes()) {}
+
+uint64_t AllocationGuard::allocations() const {
+    return threadAllocations() - startAllocations;
+}
+
+uint64_t AllocationGuard::bytes() const {
+    return threadBytes() - startBytes;
+}
+
+AllocationGuard::~AllocationGuard() {
+    uint64_t n = allocations();
+    if (policy == Policy::Report || n > 0)
+        std::fprintf(stderr, "[AllocationGuard] %s: %llu allocations, %llu bytes\n", name,
+                     (unsigned long long)n, (unsigned long long)bytes());
+    if (policy == Policy::Abort && n > 0) std::abort();
+}
+
+} // namespace alloc_prof
+
+// ---------------------------------------------------------------- replacements
+// __builtin_return_address(0) is the code that called operator new; sampled
+// call stacks start there.
+#define CALLER __builtin_return_address(0)
+
+void* operator new(std::size_t size) { return alloc_prof::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CALLER); }
+void* operator new[](std::size_t size) { return alloc_prof::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CALLER); }
+void* operator new(std::size_t size, std::align_val_t align) {
+    return alloc_prof::allocate(size, std::size_t(align), CALLER);
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return alloc_prof::allocate(size, std::size_t(align), CALLER);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_prof::allocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CALLER);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_prof::allocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CALLER);
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return alloc_prof::allocateOrNull(size, std::size_t(align), CALLER);
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return alloc_prof::allocateOrNull(size, std::size_t(align), CALLER);
+}
+
+// the header knows where the block starts, so every delete form is the same
+void operator delete(void* p) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p) noexcept { alloc_prof::deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alloc_prof::deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { alloc_prof::deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_prof::deallocate(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_prof::deallocate(p); }
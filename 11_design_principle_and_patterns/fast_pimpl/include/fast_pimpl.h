@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Fast PIMPL: the implementation object lives inside the owning object, in
+// raw storage of a size and alignment fixed in the header. No heap
+// allocation, no pointer hop, and `T` can stay an incomplete type in the header.
+//
+// All members below need `T` to be complete, so they must only be
+// instantiated in the .cpp that defines `T`. The owner therefore declares its
+// constructors, destructor and assignments in the header and defines them in
+// the .cpp (e.g. `= default` there), exactly as with the unique_ptr version.
+template<class T, std::size_t Size, std::size_t Align>
+class FastPimpl {
+public:
+    // not a candidate for a single FastPimpl argument, which would otherwise
+    // beat the copy constructor for a non-const lvalue
+    template<class... Args,
+             std::enable_if_t<!(sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, FastPimpl> && ...)),
+                              int> = 0>
+    explicit FastPimpl(Args&&... args) {
+        new (&storage) T(std::forward<Args>(args)...);
+    }
+
+    FastPimpl(const FastPimpl& other) { new (&storage) T(*other); }
+    FastPimpl(FastPimpl&& other) noexcept { new (&storage) T(std::move(*other)); }
+
+    FastPimpl& operator=(const FastPimpl& other) {
+        **this = *other;
+        return *this;
+    }
+    FastPimpl& operator=(FastPimpl&& other) noexcept {
+        **this = std::move(*other);
+        return *this;
+    }
+
+    ~FastPimpl() noexcept {
+        validate<sizeof(T), alignof(T)>();
+        get()->~T();
+    }
+
+    T* operator->() noexcept { return get(); }
+    const T* operator->() const noexcept { return get(); }
+    T& operator*() noexcept { return *get(); }
+    const T& operator*() const noexcept { return *get(); }
+
+private:
+    T* get() noexcept { return std::launder(reinterpret_cast<T*>(&storage)); }
+    const T* get() const noexcept { return std::launder(reinterpret_cast<const T*>(&storage)); }
+
+    // Instantiated in the .cpp, where sizeof(T) is known. The real values are
+    // template arguments, so they show up in the compiler's error message.
+    template<std::size_t ActualSize, std::size_t ActualAlign>
+    static constexpr void validate() noexcept {
+        static_assert(Size >= ActualSize, "FastPimpl: Size is too small for T, raise it in the header");
+        static_assert(Align % ActualAlign == 0, "FastPimpl: Align is not a multiple of alignof(T)");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "FastPimpl: moves are noexcept, T's must be too");
+        static_assert(std::is_nothrow_move_assignable_v<T>, "FastPimpl: moves are noexcept, T's must be too");
+    }
+
+    alignas(Align) unsigned char storage[Size];
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "fast_pimpl.h"
+
+// foo.h - same interface as the unique_ptr foo, impl stored inline
+class foo
+{
+  public:
+    foo();
+    ~foo();
+    foo(foo&&) noexcept;
+    foo& operator=(foo&&) noexcept;
+
+    void add(int value);
+    int result() const;
+
+  private:
+    class impl;
+    // Part of the ABI: growing impl beyond these numbers means changing them
+    // and recompiling every user, so leave some headroom.
+    FastPimpl<impl, 16, 8> pimpl;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>
+
+// heap_foo.h - the classic PIMPL from "The PIMPL idiom.ipynb", for comparison
+class heap_foo
+{
+  public:
+    heap_foo();
+    ~heap_foo();
+    heap_foo(heap_foo&&) noexcept;
+    heap_foo& operator=(heap_foo&&) noexcept;
+
+    void add(int value);
+    int result() const;
+
+  private:
+    class impl;
+    std::unique_ptr<impl> pimpl;
+};
@@ -0,0 +1,51 @@
+#include "foo.h"
+#include "heap_foo.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Time three phases for N objects of type T: construct, call, destroy
+template<class T>
+void benchmark(const char* name, int n, bool print = true) {
+    using clock = std::chrono::steady_clock;
+    auto ns = [n](clock::duration d) { return std::chrono::duration<double, std::nano>(d).count() / n; };
+
+    auto t0 = clock::now();
+    auto objects = std::make_unique<std::vector<T>>();
+    objects->reserve(n);
+    for (int i = 0; i < n; ++i) objects->emplace_back();
+    auto t1 = clock::now();
+    long long total = 0;
+    for (int round = 0; round < 10; ++round)
+        for (auto& object : *objects) object.add(round);
+    for (const auto& object : *objects) total += object.result();
+    auto t2 = clock::now();
+    objects.reset();
+    auto t3 = clock::now();
+
+    if (!print) return;
+    std::cout << name << "  sizeof " << sizeof(T) << "  construct " << ns(t1 - t0) << " ns  "
+              << "11 calls " << ns(t2 - t1) << " ns  destroy " << ns(t3 - t2) << " ns  (checksum " << total << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? std::atoi(argv[1]) : 1'000'000;
+
+    // moves keep working: the impl is moved from one inline buffer to the other
+    foo a;
+    a.add(1);
+    foo b = std::move(a);
+    b.add(1);
+    std::cout << "moved foo result: " << b.result() << "\n\n";
+
+    // warm-up pass (page faults of the first large vector, malloc's heap), not printed
+    benchmark<heap_foo>("unique_ptr PIMPL", n, false);
+    benchmark<foo>("fast PIMPL      ", n, false);
+
+    std::cout << "per object, " << n << " objects:\n";
+    benchmark<heap_foo>("unique_ptr PIMPL", n);
+    benchmark<foo>("fast PIMPL      ", n);
+}
@@ -0,0 +1,34 @@
+// foo.cpp - implementation file
+#include "foo.h"
+
+class foo::impl
+{
+  public:
+    void do_internal_work()
+    {
+      internal_data = 5;
+    }
+    void add(int value)
+    {
+      internal_data += value;
+      ++calls;
+    }
+    int result() const { return internal_data + calls; }
+
+  private:
+    int internal_data = 0;
+    int calls = 0;
+};
+
+// impl is complete from here on. The special members below instantiate
+// ~FastPimpl, whose static_asserts check that impl fits into <16, 8>.
+foo::foo() {
+  pimpl->do_internal_work();
+}
+
+foo::~foo() = default;
+foo::foo(foo&&) noexcept = default;
+foo& foo::operator=(foo&&) noexcept = default;
+
+void foo::add(int value) { pimpl->add(value); }
+int foo::result() const { return pimpl->result(); }
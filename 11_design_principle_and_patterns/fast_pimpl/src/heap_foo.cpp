@@ -0,0 +1,32 @@
+// heap_foo.cpp - implementation file
+#include "heap_foo.h"
+
+class heap_foo::impl
+{
+  public:
+    void do_internal_work()
+    {
+      internal_data = 5;
+    }
+    void add(int value)
+    {
+      internal_data += value;
+      ++calls;
+    }
+    int result() const { return internal_data + calls; }
+
+  private:
+    int internal_data = 0;
+    int calls = 0;
+};
+
+heap_foo::heap_foo():pimpl{std::make_unique<impl>()}{
+  pimpl->do_internal_work();
+}
+
+heap_foo::~heap_foo() = default;
+heap_foo::heap_foo(heap_foo&&) noexcept = default;
+heap_foo& heap_foo::operator=(heap_foo&&) noexcept = default;
+
+void heap_foo::add(int value) { pimpl->add(value); }
+int heap_foo::result() const { return pimpl->result(); }
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// How the reference count is stored and changed
+struct AtomicCount {
+    using type = std::atomic<int>;
+    static void increment(type& count) noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+    // acq_rel: every write to the object happens before the delete
+    static bool decrement(type& count) noexcept { return count.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    static int load(const type& count) noexcept { return count.load(std::memory_order_relaxed); }
+};
+
+// Plain int: only for objects that never cross threads
+struct NonAtomicCount {
+    using type = int;
+    static void increment(type& count) noexcept { ++count; }
+    static bool decrement(type& count) noexcept { return --count == 0; }
+    static int load(const type& count) noexcept { return count; }
+};
+
+template<class T>
+class IntrusivePtr;
+
+// Base class that puts the reference count into the object itself:
+//     class Resource : public RefCounted<Resource> { ... };
+//     class Local : public RefCounted<Local, NonAtomicCount> { ... };
+// An object deleted through a base IntrusivePtr needs a virtual destructor,
+// as with any delete through a base pointer.
+template<class Derived, class CountPolicy = AtomicCount>
+class RefCounted {
+public:
+    // shared_from_this: a new owner of an object that is already owned.
+    // Throws std::bad_weak_ptr if no IntrusivePtr owns it (e.g. a stack object).
+    IntrusivePtr<Derived> ptr_from_this() {
+        if (use_count() == 0) throw std::bad_weak_ptr();
+        return IntrusivePtr<Derived>(static_cast<Derived*>(this));
+    }
+    IntrusivePtr<const Derived> ptr_from_this() const {
+        if (use_count() == 0) throw std::bad_weak_ptr();
+        return IntrusivePtr<const Derived>(static_cast<const Derived*>(this));
+    }
+
+    int use_count() const noexcept { return CountPolicy::load(count); }
+
+protected:
+    RefCounted() noexcept = default;
+    // a copy of the object is a new object: it starts without owners
+    RefCounted(const RefCounted&) noexcept {}
+    RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+    ~RefCounted() = default;
+
+private:
+    template<class T>
+    friend class IntrusivePtr;
+
+    void addRef() const noexcept { CountPolicy::increment(count); }
+    void release() const noexcept {
+        if (CountPolicy::decrement(count)) delete static_cast<const Derived*>(this);
+    }
+
+    mutable typename CountPolicy::type count{0};
+};
+
+// One pointer wide, no control block. Creating it from a raw pointer adds an
+// owner, so several IntrusivePtr made from the same `this` are fine (unlike
+// std::shared_ptr<T>(this)).
+template<class T>
+class IntrusivePtr {
+public:
+    using element_type = T;
+
+    IntrusivePtr() noexcept = default;
+    IntrusivePtr(std::nullptr_t) noexcept {}
+    explicit IntrusivePtr(T* p) noexcept : ptr(p) {
+        if (ptr) ptr->addRef();
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.ptr) {}
+    IntrusivePtr(IntrusivePtr&& other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+    template<class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    IntrusivePtr(const IntrusivePtr<U>& other) noexcept : IntrusivePtr(other.get()) {}
+    template<class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    IntrusivePtr(IntrusivePtr<U>&& other) noexcept : ptr(other.detach()) {}
+
+    ~IntrusivePtr() {
+        if (ptr) ptr->release();
+    }
+
+    // copy-and-swap also covers self-assignment
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset(T* p = nullptr) noexcept { IntrusivePtr(p).swap(*this); }
+    void swap(IntrusivePtr& other) noexcept { std::swap(ptr, other.ptr); }
+
+    T* get() const noexcept { return ptr; }
+    T& operator*() const noexcept { return *ptr; }
+    T* operator->() const noexcept { return ptr; }
+    explicit operator bool() const noexcept { return ptr != nullptr; }
+    int use_count() const noexcept { return ptr ? ptr->use_count() : 0; }
+
+    friend bool operator==(const IntrusivePtr& a, const IntrusivePtr& b) noexcept { return a.ptr == b.ptr; }
+    friend bool operator!=(const IntrusivePtr& a, const IntrusivePtr& b) noexcept { return a.ptr != b.ptr; }
+
+private:
+    template<class U>
+    friend class IntrusivePtr;
+
+    // give up ownership without touching the count
+    T* detach() noexcept { return std::exchange(ptr, nullptr); }
+
+    T* ptr = nullptr;
+};
+
+template<class T, class... Args>
+IntrusivePtr<T> makeIntrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
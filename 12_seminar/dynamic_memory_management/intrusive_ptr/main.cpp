@@ -0,0 +1,122 @@
+#include "intrusive_ptr.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+// count heap bytes, to compare what each pointer really allocates
+static std::size_t heapBytes = 0;
+void* operator new(std::size_t size) {
+    heapBytes += size;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// the Resource of "5-3 understand how shared-pointer works", three ways
+struct Resource {
+    int number;
+    explicit Resource(int n) : number(n) {}
+};
+
+struct SharedResource : std::enable_shared_from_this<SharedResource> {
+    int number;
+    explicit SharedResource(int n) : number(n) {}
+    std::shared_ptr<SharedResource> getptr() { return shared_from_this(); }
+};
+
+template<class Policy>
+struct IntrusiveResource : RefCounted<IntrusiveResource<Policy>, Policy> {
+    int number;
+    explicit IntrusiveResource(int n) : number(n) {}
+    IntrusivePtr<IntrusiveResource> getptr() { return this->ptr_from_this(); }
+};
+
+using AtomicResource = IntrusiveResource<AtomicCount>;
+using LocalResource = IntrusiveResource<NonAtomicCount>;
+
+// ------------------------------------------------------------ demo
+void demo() {
+    auto p1 = makeIntrusive<AtomicResource>(111);
+    std::cout << "use_count: " << p1.use_count() << '\n';
+    {
+        IntrusivePtr<AtomicResource> p2 = p1->getptr();  // shared_from_this-style
+        IntrusivePtr<AtomicResource> p3(p1.get());       // from the raw pointer: fine, the count is in the object
+        std::cout << "use_count: " << p1.use_count() << '\n';
+    }
+    std::cout << "use_count: " << p1.use_count() << '\n';
+
+    try {
+        auto notOwned = std::make_unique<AtomicResource>(222);  // owned, but not by an IntrusivePtr
+        auto p = notOwned->getptr();
+    } catch (const std::bad_weak_ptr& e) {
+        std::cout << "ptr_from_this on an object nobody owns: " << e.what() << '\n';
+    }
+}
+
+// ------------------------------------------------------------ benchmark
+template<class F>
+double nsPer(std::size_t operations, F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / operations;
+}
+
+// N objects; copy all N pointers and destroy the copies, `rounds` times
+template<class Ptr, class Make>
+void run(const char* name, std::size_t n, int rounds, Make make) {
+    heapBytes = 0;
+    std::vector<Ptr> objects;
+    objects.reserve(n);
+    double create = nsPer(n, [&] {
+        for (std::size_t i = 0; i < n; ++i) objects.push_back(make(int(i)));
+    });
+    std::size_t perObject = (heapBytes - n * sizeof(Ptr)) / n;
+
+    long long checksum = 0;
+    double copy = nsPer(n * rounds, [&] {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<Ptr> copies(objects);  // n increments
+            checksum += copies.back()->number;
+        }                                      // n decrements
+    });
+    double destroy = nsPer(n, [&] { objects.clear(); });
+
+    std::cout << name << "  sizeof(ptr) " << sizeof(Ptr) << "  heap/object " << perObject << " B  create "
+              << create << " ns  copy+destroy " << copy << " ns  destroy " << destroy << " ns"
+              << (checksum < 0 ? "!" : "") << '\n';
+}
+
+void benchmark() {
+    for (std::size_t n : {1000, 1000000}) {
+        int rounds = n == 1000 ? 20000 : 20;
+        std::cout << n << " objects, per object:\n";
+        run<std::shared_ptr<Resource>>("shared_ptr(new)               ", n, rounds,
+                                       [](int i) { return std::shared_ptr<Resource>(new Resource(i)); });
+        run<std::shared_ptr<Resource>>("make_shared                   ", n, rounds,
+                                       [](int i) { return std::make_shared<Resource>(i); });
+        run<std::shared_ptr<SharedResource>>("make_shared + shared_from_this", n, rounds,
+                                             [](int i) { return std::make_shared<SharedResource>(i); });
+        run<IntrusivePtr<AtomicResource>>("IntrusivePtr, atomic          ", n, rounds,
+                                          [](int i) { return makeIntrusive<AtomicResource>(i); });
+        run<IntrusivePtr<LocalResource>>("IntrusivePtr, non-atomic      ", n, rounds,
+                                         [](int i) { return makeIntrusive<LocalResource>(i); });
+    }
+}
+
+int main() {
+    demo();
+
+    // libstdc++ switches shared_ptr to plain increments while the process
+    // has only one thread (__libc_single_threaded), so measure both cases
+    std::cout << "\n=== single-threaded process ===\n";
+    benchmark();
+    std::thread([] {}).join();
+    std::cout << "\n=== after a second thread was started ===\n";
+    benchmark();
+}
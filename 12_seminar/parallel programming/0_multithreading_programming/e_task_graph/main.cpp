@@ -0,0 +1,361 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+
+// Same worker set as in d_thread_pool: every graph node is executed by one of these threads
+class ThreadPool {
+public:
+    ThreadPool(size_t numThreads) : stop(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this] {
+                            return this->stop || !this->tasks.empty();
+                        });
+                        if (this->stop && this->tasks.empty()) return;
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace([task] { task(); });
+        }
+        condition.notify_one();
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+};
+
+class TaskGraph;
+
+// Type-erased part of a node: edges, dependency counter and timings
+class NodeBase {
+public:
+    explicit NodeBase(std::string name) : name(std::move(name)) {}
+    virtual ~NodeBase() = default;
+    virtual void run() = 0;
+
+private:
+    friend class TaskGraph;
+
+    std::string name;
+    std::vector<size_t> successors;   // indices of nodes that wait for this one
+    size_t numPredecessors = 0;
+    std::atomic<size_t> pending{0};   // inputs that are not ready yet in the current run
+    std::chrono::duration<double> startTime{0};
+    std::chrono::duration<double> endTime{0};
+};
+
+// A node producing a value of type T; the value stays inside the node and
+// successors read it through a const reference, so nothing is copied along an edge
+template<class T>
+class Node : public NodeBase {
+public:
+    Node(std::string name, std::function<T()> body)
+        : NodeBase(std::move(name)), body(std::move(body)) {}
+
+    void run() override { result.emplace(body()); }
+    const T& get() const { return *result; }
+
+private:
+    std::function<T()> body;
+    std::optional<T> result;
+};
+
+template<>
+class Node<void> : public NodeBase {
+public:
+    Node(std::string name, std::function<void()> body)
+        : NodeBase(std::move(name)), body(std::move(body)) {}
+
+    void run() override { body(); }
+
+private:
+    std::function<void()> body;
+};
+
+// Handle returned to the user; it is what gets passed as an input to later nodes
+template<class T>
+class TaskNode {
+public:
+    decltype(auto) get() const { return node->get(); }
+
+private:
+    friend class TaskGraph;
+    TaskNode(Node<T>* node, size_t index) : node(node), index(index) {}
+
+    Node<T>* node;
+    size_t index;
+};
+
+class TaskGraph {
+public:
+    // Add a node whose body receives the results of `inputs` (in order) as const references.
+    // An edge from every input to the new node is added automatically.
+    template<class F, class... Ins>
+    auto emplace(std::string name, F&& f, TaskNode<Ins>... inputs) {
+        using R = std::invoke_result_t<F&, const Ins&...>;
+        std::function<R()> body = [f = std::forward<F>(f), inputs...]() mutable -> R {
+            return f(inputs.get()...);
+        };
+        auto node = std::make_unique<Node<R>>(std::move(name), std::move(body));
+        Node<R>* raw = node.get();
+        size_t index = nodes.size();
+        nodes.push_back(std::move(node));
+        (precede(inputs, TaskNode<R>(raw, index)), ...);
+        return TaskNode<R>(raw, index);
+    }
+
+    // Add an ordering-only edge: `to` does not start before `from` has finished
+    template<class A, class B>
+    void precede(const TaskNode<A>& from, const TaskNode<B>& to) {
+        nodes[from.index]->successors.push_back(to.index);
+        ++nodes[to.index]->numPredecessors;
+    }
+
+    // Execute the whole graph on `pool`; every node is enqueued as soon as its
+    // last input finishes. Blocks until all nodes are done and rethrows the
+    // first exception thrown by a node.
+    void run(ThreadPool& pool) {
+        checkAcyclic();
+
+        remaining = nodes.size();
+        firstError = nullptr;
+        for (auto& node : nodes)
+            node->pending = node->numPredecessors;
+
+        runStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodes.size(); ++i)
+            if (nodes[i]->numPredecessors == 0)
+                schedule(pool, i);
+
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [this] { return remaining == 0; });
+        wallTime = std::chrono::steady_clock::now() - runStart;
+        if (firstError)
+            std::rethrow_exception(firstError);
+    }
+
+    // Print per-node timings of the last run and the critical path through the graph
+    void report(std::ostream& os) const {
+        os << std::fixed << std::setprecision(3);
+        os << "Node timings (seconds since run start):\n";
+        for (const auto& node : nodes) {
+            os << "  " << std::left << std::setw(24) << node->name << std::right
+               << " start " << node->startTime.count()
+               << "  end " << node->endTime.count()
+               << "  took " << (node->endTime - node->startTime).count() << "\n";
+        }
+
+        std::vector<size_t> path = criticalPath();
+        double length = 0.0;
+        os << "Critical path: ";
+        for (size_t i = 0; i < path.size(); ++i) {
+            const auto& node = nodes[path[i]];
+            length += (node->endTime - node->startTime).count();
+            os << (i ? " -> " : "") << node->name;
+        }
+        os << "\nCritical path length: " << length << " s, wall time: "
+           << wallTime.count() << " s\n";
+    }
+
+private:
+    void schedule(ThreadPool& pool, size_t index) {
+        pool.enqueue([this, &pool, index] { execute(pool, index); });
+    }
+
+    void execute(ThreadPool& pool, size_t index) {
+        NodeBase& node = *nodes[index];
+        node.startTime = std::chrono::steady_clock::now() - runStart;
+        try {
+            node.run();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (!firstError) firstError = std::current_exception();
+        }
+        node.endTime = std::chrono::steady_clock::now() - runStart;
+
+        // A failed node still releases its successors so the run always terminates;
+        // they are skipped instead of being executed on a missing input.
+        for (size_t next : node.successors) {
+            if (nodes[next]->pending.fetch_sub(1) == 1) {
+                if (hasFailed()) finishSkipped(next);
+                else schedule(pool, next);
+            }
+        }
+        finishOne();
+    }
+
+    void finishSkipped(size_t index) {
+        NodeBase& node = *nodes[index];
+        node.startTime = node.endTime = std::chrono::steady_clock::now() - runStart;
+        for (size_t next : node.successors)
+            if (nodes[next]->pending.fetch_sub(1) == 1)
+                finishSkipped(next);
+        finishOne();
+    }
+
+    bool hasFailed() {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        return firstError != nullptr;
+    }
+
+    void finishOne() {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        if (--remaining == 0)
+            done.notify_all();
+    }
+
+    // Kahn's algorithm; ordering edges added with precede() may introduce a cycle
+    void checkAcyclic() const {
+        std::vector<size_t> indegree(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i)
+            indegree[i] = nodes[i]->numPredecessors;
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < nodes.size(); ++i)
+            if (indegree[i] == 0) ready.push_back(i);
+        size_t visited = 0;
+        while (!ready.empty()) {
+            size_t i = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (size_t next : nodes[i]->successors)
+                if (--indegree[next] == 0) ready.push_back(next);
+        }
+        if (visited != nodes.size())
+            throw std::logic_error("TaskGraph contains a cycle");
+    }
+
+    // Longest chain of measured node durations, i.e. the lower bound on wall time
+    std::vector<size_t> criticalPath() const {
+        size_t n = nodes.size();
+        std::vector<size_t> order;
+        std::vector<size_t> indegree(n);
+        for (size_t i = 0; i < n; ++i) {
+            indegree[i] = nodes[i]->numPredecessors;
+            if (indegree[i] == 0) order.push_back(i);
+        }
+        for (size_t k = 0; k < order.size(); ++k)
+            for (size_t next : nodes[order[k]]->successors)
+                if (--indegree[next] == 0) order.push_back(next);
+
+        std::vector<double> finish(n, 0.0);
+        std::vector<size_t> parent(n, n);
+        for (size_t i : order) {
+            finish[i] += (nodes[i]->endTime - nodes[i]->startTime).count();
+            for (size_t next : nodes[i]->successors) {
+                if (finish[i] > finish[next]) {
+                    finish[next] = finish[i];
+                    parent[next] = i;
+                }
+            }
+        }
+
+        std::vector<size_t> path;
+        if (n == 0) return path;
+        size_t last = std::max_element(finish.begin(), finish.end()) - finish.begin();
+        for (size_t i = last; i != n; i = parent[i])
+            path.push_back(i);
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::vector<std::unique_ptr<NodeBase>> nodes;
+    std::mutex done_mutex;
+    std::condition_variable done;
+    size_t remaining = 0;
+    std::exception_ptr firstError;
+    std::chrono::steady_clock::time_point runStart;
+    std::chrono::duration<double> wallTime{0};
+};
+
+using Matrix = std::vector<double>;
+
+// Simulate matrix multiplication (produces a matrix)
+Matrix matrixMultiplication(size_t n) {
+    std::cout << "Matrix multiplication started, thread ID: " << std::this_thread::get_id() << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    return Matrix(n * n, 1.0);
+}
+
+// Simulate image processing (needs the matrix as a filter kernel)
+std::vector<float> imageProcessing(const Matrix& kernel) {
+    std::cout << "Image processing started, thread ID: " << std::this_thread::get_id() << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    return std::vector<float>(kernel.size(), 0.5f);
+}
+
+// Simulate scientific computation (independent of the other stages)
+double scientificComputation(int durationInMilliseconds) {
+    std::cout << "Scientific computation started, thread ID: " << std::this_thread::get_id() << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(durationInMilliseconds));
+    return 42.0;
+}
+
+int main() {
+    ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()));
+    TaskGraph graph;
+
+    // matrix -> image -> combine
+    //        \-> trace  -/
+    // science ----------/
+    auto matrix = graph.emplace("matrixMultiplication", [] { return matrixMultiplication(512); });
+    auto image = graph.emplace("imageProcessing", imageProcessing, matrix);
+    auto trace = graph.emplace("trace", [](const Matrix& m) {
+        return std::accumulate(m.begin(), m.end(), 0.0);
+    }, matrix);
+    auto science = graph.emplace("scientificComputation", [] { return scientificComputation(400); });
+    auto combine = graph.emplace("combine", [](const std::vector<float>& img, double tr, double sci) {
+        return img.size() + tr + sci;
+    }, image, trace, science);
+    auto print = graph.emplace("print", [](double value) {
+        std::cout << "Combined result: " << value << std::endl;
+    }, combine);
+    (void)print;
+
+    graph.run(pool);
+    graph.report(std::cout);
+    return 0;
+}
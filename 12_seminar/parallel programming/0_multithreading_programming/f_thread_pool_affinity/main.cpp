@@ -0,0 +1,380 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Parse a kernel cpu list such as "0-3,8-11" into {0,1,2,3,8,9,10,11}
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// One logical CPU as seen by the kernel
+struct CpuInfo {
+    int cpu;      // logical cpu number used by sched_setaffinity
+    int core;     // physical core id (SMT siblings share it)
+    int package;  // socket
+    int node;     // NUMA node
+};
+
+// Machine layout read from /sys on Linux; a single node with
+// hardware_concurrency() cpus everywhere else (or if /sys is not readable)
+struct Topology {
+    std::vector<CpuInfo> cpus;
+    int numNodes = 1;
+
+    static Topology detect() {
+        Topology topo;
+#ifdef __linux__
+        const std::string cpuRoot = "/sys/devices/system/cpu/";
+        const std::string nodeRoot = "/sys/devices/system/node/";
+
+        std::vector<int> online = parseCpuList(readFirstLine(cpuRoot + "online"));
+        std::vector<int> nodes = parseCpuList(readFirstLine(nodeRoot + "online"));
+        for (int cpu : online) {
+            std::string dir = cpuRoot + "cpu" + std::to_string(cpu) + "/topology/";
+            std::string core = readFirstLine(dir + "core_id");
+            std::string package = readFirstLine(dir + "physical_package_id");
+            topo.cpus.push_back({cpu, core.empty() ? cpu : std::stoi(core),
+                                 package.empty() ? 0 : std::stoi(package), 0});
+        }
+        int nodeIndex = 0;
+        for (int node : nodes) {
+            for (int cpu : parseCpuList(readFirstLine(nodeRoot + "node" + std::to_string(node) + "/cpulist")))
+                for (auto& info : topo.cpus)
+                    if (info.cpu == cpu) info.node = nodeIndex;
+            ++nodeIndex;
+        }
+        topo.numNodes = std::max(1, nodeIndex);
+#endif
+        if (topo.cpus.empty()) {
+            unsigned n = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < n; ++i)
+                topo.cpus.push_back({static_cast<int>(i), static_cast<int>(i), 0, 0});
+            topo.numNodes = 1;
+        }
+        return topo;
+    }
+
+    // Cpus of one node, ordered for the given pinning strategy:
+    //  spread  - first hyperthread of every core, then the second ones
+    //  compact - both hyperthreads of a core next to each other
+    std::vector<int> cpusOfNode(int node, bool compact) const {
+        std::vector<CpuInfo> mine;
+        for (const auto& info : cpus)
+            if (info.node == node) mine.push_back(info);
+        std::sort(mine.begin(), mine.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.package != b.package) return a.package < b.package;
+            if (a.core != b.core) return a.core < b.core;
+            return a.cpu < b.cpu;
+        });
+        // rank = index of the cpu among its SMT siblings
+        std::vector<std::pair<int, int>> ranked;
+        for (size_t i = 0; i < mine.size(); ++i) {
+            int rank = 0;
+            for (size_t j = 0; j < i; ++j)
+                if (mine[j].package == mine[i].package && mine[j].core == mine[i].core) ++rank;
+            ranked.push_back({rank, mine[i].cpu});
+        }
+        if (!compact)
+            std::stable_sort(ranked.begin(), ranked.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<int> result;
+        for (const auto& r : ranked) result.push_back(r.second);
+        return result;
+    }
+};
+
+enum class Pinning {
+    None,         // let the OS scheduler place and migrate workers
+    Cores,        // one worker per physical core before using SMT siblings
+    SmtSiblings   // fill both hyperthreads of a core first (workers share L1/L2)
+};
+
+struct ThreadPoolOptions {
+    size_t numThreads = 0;           // 0 -> std::thread::hardware_concurrency()
+    Pinning pinning = Pinning::None;
+    bool numaQueues = false;         // one task queue per NUMA node
+};
+
+class ThreadPool {
+public:
+    ThreadPool(size_t numThreads) : ThreadPool(ThreadPoolOptions{numThreads}) {}
+
+    explicit ThreadPool(const ThreadPoolOptions& options, const Topology& topo = Topology::detect())
+        : stop(false) {
+        size_t numThreads = options.numThreads;
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        // Every queue needs at least one worker, so never create more queues than workers
+        size_t numQueues = options.numaQueues ? std::min<size_t>(topo.numNodes, numThreads) : 1;
+        for (size_t q = 0; q < numQueues; ++q)
+            queues.emplace_back(new NodeQueue);
+
+        // Workers are dealt round-robin over the NUMA nodes; inside a node
+        // they take the cpus in the order chosen by the pinning strategy
+        std::vector<std::vector<int>> nodeCpus;
+        for (int node = 0; node < topo.numNodes; ++node)
+            nodeCpus.push_back(topo.cpusOfNode(node, options.pinning == Pinning::SmtSiblings));
+
+        for (size_t i = 0; i < numThreads; ++i) {
+            int node = static_cast<int>(i % topo.numNodes);
+            size_t queue = i % numQueues;
+            int cpu = -1;
+            if (options.pinning != Pinning::None && !nodeCpus[node].empty()) {
+                size_t slot = i / topo.numNodes;
+                cpu = nodeCpus[node][slot % nodeCpus[node].size()];
+            }
+            workers.emplace_back([this, queue, cpu] {
+                pinCurrentThread(cpu);
+                workerLoop(queue);
+            });
+        }
+    }
+
+    // Tasks without a node are spread round-robin over the node queues
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        size_t queue = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        push(queue, std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    // Run the task on a worker of `node`, so memory it touches first is
+    // allocated on that node. If all workers of `node` are busy, an idle
+    // worker of another node is woken to steal it.
+    template<class F, class... Args>
+    void enqueueOnNode(size_t node, F&& f, Args&&... args) {
+        push(node % queues.size(), std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    }
+
+    size_t size() const { return workers.size(); }
+    size_t numNodes() const { return queues.size(); }
+
+    ~ThreadPool() {
+        for (auto& q : queues) {
+            std::unique_lock<std::mutex> lock(q->mutex);
+            stop = true;
+        }
+        for (auto& q : queues)
+            q->condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    struct NodeQueue {
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        int idle = 0;    // workers of this node waiting on `condition`
+        int steal = 0;   // wake-ups asking an idle worker to steal from another node
+    };
+
+    template<class Task>
+    void push(size_t queue, Task task) {
+        NodeQueue& q = *queues[queue];
+        bool hasIdle;
+        {
+            std::unique_lock<std::mutex> lock(q.mutex);
+            q.tasks.emplace([task] { task(); });
+            hasIdle = q.idle > 0;
+        }
+        q.condition.notify_one();
+        // the node is busy: let an idle worker of another node steal the task
+        if (!hasIdle) wakeStealer(queue);
+    }
+
+    void wakeStealer(size_t busy) {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            NodeQueue& other = *queues[(busy + k) % queues.size()];
+            std::unique_lock<std::mutex> lock(other.mutex);
+            if (other.idle > other.steal) {
+                ++other.steal;
+                lock.unlock();
+                other.condition.notify_one();
+                return;
+            }
+        }
+    }
+
+    static bool tryPop(NodeQueue& q, std::function<void()>& task) {
+        std::unique_lock<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        task = std::move(q.tasks.front());
+        q.tasks.pop();
+        return true;
+    }
+
+    // Own node first, then steal from the other nodes
+    bool tryPopAny(size_t own, std::function<void()>& task) {
+        for (size_t k = 0; k < queues.size(); ++k)
+            if (tryPop(*queues[(own + k) % queues.size()], task)) return true;
+        return false;
+    }
+
+    void workerLoop(size_t own) {
+        NodeQueue& q = *queues[own];
+        while (true) {
+            std::function<void()> task;
+            if (!tryPopAny(own, task)) {
+                std::unique_lock<std::mutex> lock(q.mutex);
+                ++q.idle;
+                q.condition.wait(lock, [this, &q] {
+                    return this->stop || !q.tasks.empty() || q.steal > 0;
+                });
+                --q.idle;
+                if (q.tasks.empty() && q.steal > 0 && !this->stop) {
+                    // woken for another node's task: look for it (it may be gone already)
+                    --q.steal;
+                    continue;
+                }
+                if (q.tasks.empty()) {
+                    // stop requested: drain whatever is left on other nodes, then exit
+                    lock.unlock();
+                    if (!tryPopAny(own, task)) return;
+                } else {
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop();
+                }
+            }
+            task();
+        }
+    }
+
+    static void pinCurrentThread(int cpu) {
+#ifdef __linux__
+        if (cpu < 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            std::cerr << "warning: could not pin worker to cpu " << cpu << std::endl;
+#else
+        (void)cpu;
+#endif
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<NodeQueue>> queues;
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<bool> stop;
+};
+
+// Run fn(chunk) for every chunk and wait. With `onNodes` chunk k goes to node
+// k * nodes / numChunks, i.e. each node owns one contiguous slice of the arrays.
+template<class F>
+void parallelChunks(ThreadPool& pool, size_t numChunks, bool onNodes, F fn) {
+    std::vector<std::future<void>> done;
+    for (size_t k = 0; k < numChunks; ++k) {
+        auto finished = std::make_shared<std::promise<void>>();
+        done.push_back(finished->get_future());
+        auto task = [fn, k, finished] { fn(k); finished->set_value(); };
+        if (onNodes) pool.enqueueOnNode(k * pool.numNodes() / numChunks, task);
+        else pool.enqueue(task);
+    }
+    for (auto& f : done) f.get();
+}
+
+// STREAM-style triad a = b + s * c: three streams, almost no arithmetic,
+// so throughput is bounded by memory bandwidth and memory placement
+double triadBandwidth(ThreadPool& pool, size_t n, bool firstTouch, int reps) {
+    // new double[n] leaves the pages untouched, so whoever writes them first decides their node
+    std::unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+    size_t numChunks = pool.size() * 4;
+    size_t chunk = (n + numChunks - 1) / numChunks;
+    auto range = [&](size_t k) {
+        return std::make_pair(std::min(n, k * chunk), std::min(n, (k + 1) * chunk));
+    };
+
+    if (firstTouch) {
+        parallelChunks(pool, numChunks, true, [&](size_t k) {
+            auto r = range(k);
+            for (size_t i = r.first; i < r.second; ++i) { a[i] = 0.0; b[i] = 1.0; c[i] = 2.0; }
+        });
+    } else {
+        // the usual way: the main thread initialises everything, so all pages land on its node
+        for (size_t i = 0; i < n; ++i) { a[i] = 0.0; b[i] = 1.0; c[i] = 2.0; }
+    }
+
+    const double s = 3.0;
+    double best = 1e30;
+    for (int rep = 0; rep < reps; ++rep) {
+        auto start = std::chrono::steady_clock::now();
+        parallelChunks(pool, numChunks, firstTouch, [&](size_t k) {
+            auto r = range(k);
+            for (size_t i = r.first; i < r.second; ++i) a[i] = b[i] + s * c[i];
+        });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    if (a[n / 2] != 7.0) std::cerr << "triad produced a wrong result" << std::endl;
+    return 3.0 * n * sizeof(double) / best / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    // Size of each of the three arrays in MiB (default 128 MiB, well beyond any L3)
+    size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 128;
+    if (mib == 0) {
+        std::cerr << "usage: " << argv[0] << " [MiB per array, > 0]" << std::endl;
+        return 1;
+    }
+    size_t n = mib * 1024 * 1024 / sizeof(double);
+
+    Topology topo = Topology::detect();
+    std::cout << "Detected " << topo.cpus.size() << " cpus on " << topo.numNodes << " NUMA node(s)\n";
+    for (const auto& info : topo.cpus)
+        std::cout << "  cpu " << info.cpu << ": core " << info.core
+                  << ", package " << info.package << ", node " << info.node << "\n";
+
+    struct Config { const char* name; ThreadPoolOptions options; bool firstTouch; };
+    std::vector<Config> configs = {
+        {"unpinned, main-thread init     ", {0, Pinning::None, false}, false},
+        {"pinned to cores, main-thread init", {0, Pinning::Cores, false}, false},
+        {"pinned + NUMA queues + first touch", {0, Pinning::Cores, true}, true},
+        {"SMT siblings + NUMA queues + first touch", {0, Pinning::SmtSiblings, true}, true},
+    };
+
+    std::cout << "\nTriad over 3 x " << mib << " MiB, best of 10:\n";
+    for (const auto& config : configs) {
+        ThreadPool pool(config.options, topo);
+        double gbs = triadBandwidth(pool, n, config.firstTouch, 10);
+        std::cout << "  " << config.name << " (" << pool.size() << " workers, "
+                  << pool.numNodes() << " queue(s)): " << gbs << " GB/s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,560 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <system_error>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using Clock = std::chrono::steady_clock;
+
+// Bytes currently held by coroutine frames (task<T> and detached frames)
+std::atomic<size_t> frameBytes{0};
+
+struct FrameAllocation {
+    static void* operator new(size_t size) {
+        frameBytes.fetch_add(size, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    static void operator delete(void* p, size_t size) {
+        frameBytes.fetch_sub(size, std::memory_order_relaxed);
+        ::operator delete(p);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// task<T>: a lazily started coroutine. `co_await t` starts it and resumes the
+// awaiting coroutine when it finishes (symmetric transfer, no extra thread).
+// ---------------------------------------------------------------------------
+template<class T = void>
+class task;
+
+namespace detail {
+
+template<class Promise>
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+        if (auto next = h.promise().continuation) return next;
+        return std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase : FrameAllocation {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+} // namespace detail
+
+template<class T>
+class task {
+public:
+    struct promise_type : detail::PromiseBase {
+        std::optional<T> value;
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        detail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+        template<class U>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    };
+
+    task(task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    task(const task&) = delete;
+    ~task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<>
+class task<void> {
+public:
+    struct promise_type : detail::PromiseBase {
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        detail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+        void return_void() {}
+    };
+
+    task(task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    task(const task&) = delete;
+    ~task() { if (handle) handle.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    void await_resume() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// ---------------------------------------------------------------------------
+// Executor: a few worker threads resume ready coroutines; one reactor thread
+// blocks in epoll_wait on a timerfd (all sleeps), an eventfd (shutdown) and
+// the file descriptors coroutines are waiting on.
+// ---------------------------------------------------------------------------
+class Executor {
+public:
+    explicit Executor(size_t numWorkers) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epfd < 0 || timerfd < 0 || wakefd < 0)
+            throw std::system_error(errno, std::generic_category(), "Executor");
+        watch(timerfd, &timerfd);
+        watch(wakefd, &wakefd);
+
+        reactor = std::thread([this] { reactorLoop(); });
+        for (size_t i = 0; i < numWorkers; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~Executor() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        uint64_t one = 1;
+        (void)!write(wakefd, &one, sizeof(one));
+        reactor.join();
+        for (std::thread &worker : workers)
+            worker.join();
+        close(epfd);
+        close(timerfd);
+        close(wakefd);
+    }
+
+    // Start a top-level task; the executor owns it until it finishes
+    void spawn(task<void> t) {
+        {
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            ++outstanding;
+        }
+        schedule(runDetached(this, std::move(t)).handle);
+    }
+
+    // Block the calling (non-worker) thread until every spawned task has finished
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle.wait(lock, [this] { return outstanding == 0; });
+    }
+
+    void schedule(std::coroutine_handle<> h) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            ready.push_back(h);
+        }
+        condition.notify_one();
+    }
+
+    void addTimer(Clock::time_point when, std::coroutine_handle<> h) {
+        std::unique_lock<std::mutex> lock(timer_mutex);
+        timers.push({when, h});
+        if (timers.top().handle == h)
+            armTimer(when);
+    }
+
+    // Resume `h` once `fd` is readable (one shot)
+    void addReader(int fd, std::coroutine_handle<> h) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.ptr = h.address();
+        if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0 &&
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+    }
+
+    // Executor of the worker thread currently running a coroutine
+    static Executor*& current() {
+        thread_local Executor* executor = nullptr;
+        return executor;
+    }
+
+private:
+    struct Detached {
+        struct promise_type : FrameAllocation {
+            Detached get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }  // frame frees itself
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    static Detached runDetached(Executor* ex, task<void> t) {
+        try {
+            co_await t;
+        } catch (const std::exception& e) {
+            std::cerr << "spawned task failed: " << e.what() << std::endl;
+        }
+        ex->taskDone();
+    }
+
+    void taskDone() {
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        if (--outstanding == 0)
+            idle.notify_all();
+    }
+
+    struct Timer {
+        Clock::time_point when;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const { return when > other.when; }
+    };
+
+    void watch(int fd, void* tag) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = tag;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    // timerfd uses CLOCK_MONOTONIC, which is what steady_clock reads on Linux
+    void armTimer(Clock::time_point when) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        itimerspec spec{};
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1;  // all-zero would disarm the timer
+        timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    void fireTimers() {
+        uint64_t expirations;
+        (void)!read(timerfd, &expirations, sizeof(expirations));
+        std::vector<std::coroutine_handle<>> due;
+        {
+            std::unique_lock<std::mutex> lock(timer_mutex);
+            auto now = Clock::now();
+            while (!timers.empty() && timers.top().when <= now) {
+                due.push_back(timers.top().handle);
+                timers.pop();
+            }
+            if (!timers.empty())
+                armTimer(timers.top().when);
+        }
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            ready.insert(ready.end(), due.begin(), due.end());
+        }
+        if (due.size() == 1) condition.notify_one();
+        else if (!due.empty()) condition.notify_all();
+    }
+
+    void reactorLoop() {
+        epoll_event events[256];
+        while (true) {
+            int n = epoll_wait(epfd, events, 256, -1);
+            for (int i = 0; i < n; ++i) {
+                void* tag = events[i].data.ptr;
+                if (tag == &wakefd) return;
+                if (tag == &timerfd) fireTimers();
+                else schedule(std::coroutine_handle<>::from_address(tag));
+            }
+        }
+    }
+
+    void workerLoop() {
+        current() = this;
+        while (true) {
+            std::coroutine_handle<> h;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                condition.wait(lock, [this] { return stop || !ready.empty(); });
+                if (stop && ready.empty()) return;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+    int epfd, timerfd, wakefd;
+    std::thread reactor;
+    std::vector<std::thread> workers;
+
+    std::deque<std::coroutine_handle<>> ready;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop = false;
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::mutex timer_mutex;
+
+    size_t outstanding = 0;
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+};
+
+// ---------------------------------------------------------------------------
+// Awaitables
+// ---------------------------------------------------------------------------
+
+// co_await sleep_for(100ms): suspends the coroutine, not the thread
+struct SleepAwaiter {
+    Clock::time_point when;
+    bool await_ready() const { return when <= Clock::now(); }
+    void await_suspend(std::coroutine_handle<> h) { Executor::current()->addTimer(when, h); }
+    void await_resume() const {}
+};
+
+template<class Rep, class Period>
+SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> d) {
+    return {Clock::now() + std::chrono::duration_cast<Clock::duration>(d)};
+}
+
+// co_await async_read(fd, buf, n): returns what read(2) returns. The fd is
+// switched to non-blocking; if no data is available the coroutine waits for
+// EPOLLIN. Regular files are always readable for epoll, so for them this
+// degrades to a plain read on the worker thread.
+struct ReadAwaiter {
+    int fd;
+    void* buffer;
+    size_t size;
+    ssize_t result = -1;
+    int error = 0;  // errno is per thread, and we may be resumed on another one
+
+    bool tryRead() {
+        result = read(fd, buffer, size);
+        error = result < 0 ? errno : 0;
+        return error != EAGAIN && error != EWOULDBLOCK;
+    }
+    bool await_ready() {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return tryRead();
+    }
+    void await_suspend(std::coroutine_handle<> h) { Executor::current()->addReader(fd, h); }
+    ssize_t await_resume() {
+        if (error == EAGAIN || error == EWOULDBLOCK)
+            tryRead();
+        if (result < 0)
+            throw std::system_error(error, std::generic_category(), "async_read");
+        return result;
+    }
+};
+
+inline ReadAwaiter async_read(int fd, void* buffer, size_t size) { return {fd, buffer, size}; }
+
+// Multi-producer / multi-consumer channel; co_await ch.pop() suspends while empty
+template<class T>
+class Channel {
+public:
+    void push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (waiters.empty()) {
+            values.push_back(std::move(value));
+            return;
+        }
+        PopAwaiter* waiter = waiters.front();
+        waiters.pop_front();
+        lock.unlock();
+        waiter->value.emplace(std::move(value));  // hand over directly to the sleeping consumer
+        waiter->executor->schedule(waiter->handle);
+    }
+
+    struct PopAwaiter {
+        Channel& channel;
+        std::optional<T> value;
+        Executor* executor = nullptr;
+        std::coroutine_handle<> handle;
+
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            std::unique_lock<std::mutex> lock(channel.mutex);
+            if (!channel.values.empty()) {
+                value.emplace(std::move(channel.values.front()));
+                channel.values.pop_front();
+                return false;  // do not suspend
+            }
+            executor = Executor::current();
+            handle = h;
+            channel.waiters.push_back(this);
+            return true;
+        }
+        T await_resume() { return std::move(*value); }
+    };
+
+    PopAwaiter pop() { return PopAwaiter{*this, std::nullopt, nullptr, {}}; }
+
+private:
+    std::mutex mutex;
+    std::deque<T> values;
+    std::deque<PopAwaiter*> waiters;
+};
+
+// ---------------------------------------------------------------------------
+// The examples from the thread pool lesson, written as coroutines
+// ---------------------------------------------------------------------------
+task<void> processTask(int taskId, std::string message, double value) {
+    std::cout << "Starting task " << taskId << " (" << message << ", " << value << ")"
+              << " on thread " << std::this_thread::get_id() << std::endl;
+    co_await sleep_for(std::chrono::milliseconds(200));  // the thread runs other tasks meanwhile
+    std::cout << "Completed task " << taskId << " on thread " << std::this_thread::get_id() << std::endl;
+}
+
+task<int> producer(Channel<int>& channel, int id) {
+    for (int i = 0; i < 5; ++i) {
+        co_await sleep_for(std::chrono::milliseconds(10));
+        channel.push(id * 100 + i);
+    }
+    co_return 5;
+}
+
+task<void> producers(Channel<int>& channel) {
+    int produced = co_await producer(channel, 1);
+    produced += co_await producer(channel, 2);
+    std::cout << "Producers pushed " << produced << " items" << std::endl;
+}
+
+task<void> consumer(Channel<int>& channel, int count) {
+    int sum = 0;
+    for (int i = 0; i < count; ++i)
+        sum += co_await channel.pop();
+    std::cout << "Consumer received " << count << " items, sum " << sum << std::endl;
+}
+
+task<void> pipeReader(int fd) {
+    char buffer[64];
+    ssize_t n = co_await async_read(fd, buffer, sizeof(buffer));
+    std::cout << "Read " << n << " bytes from pipe: " << std::string(buffer, n) << std::endl;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: many concurrent sleepers on a handful of threads
+// ---------------------------------------------------------------------------
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+std::atomic<int> suspendedNow{0};
+
+task<void> sleeper(std::chrono::milliseconds delay, double& latencyMicros) {
+    auto deadline = Clock::now() + delay;
+    suspendedNow.fetch_add(1, std::memory_order_relaxed);
+    co_await sleep_for(delay);
+    latencyMicros = std::chrono::duration<double, std::micro>(Clock::now() - deadline).count();
+}
+
+void benchmark(Executor& ex, size_t numTasks) {
+    std::vector<double> latency(numTasks);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> delay(500, 1500);
+
+    size_t rssBefore = residentBytes();
+    suspendedNow = 0;
+    for (size_t i = 0; i < numTasks; ++i)
+        ex.spawn(sleeper(std::chrono::milliseconds(delay(rng)), latency[i]));
+
+    // wait until every task is parked on its timer, then sample memory
+    while (suspendedNow.load() < static_cast<int>(numTasks))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    size_t frames = frameBytes.load();
+    size_t rssDuring = residentBytes();
+
+    ex.waitIdle();
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&](double p) { return latency[static_cast<size_t>(p * (numTasks - 1))]; };
+
+    std::cout << "\n" << numTasks << " suspended coroutines:\n"
+              << "  coroutine frame bytes per task: " << frames / numTasks << "\n"
+              << "  RSS growth per task:            " << (rssDuring - rssBefore) / numTasks << " bytes\n"
+              << "  wake-up latency p50/p99/max:    " << pct(0.5) << " / " << pct(0.99)
+              << " / " << latency.back() << " us" << std::endl;
+}
+
+// Same wait with one OS thread per outstanding sleep, for comparison
+void threadBaseline(size_t numThreads) {
+    std::vector<std::thread> threads;
+    std::atomic<size_t> started{0};
+    size_t rssBefore = residentBytes();
+    for (size_t i = 0; i < numThreads; ++i)
+        threads.emplace_back([&started] {
+            started.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        });
+    while (started.load() < numThreads)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    size_t rssDuring = residentBytes();
+    for (auto& t : threads) t.join();
+    std::cout << "\n" << numThreads << " sleeping std::threads:\n"
+              << "  RSS growth per thread:          " << (rssDuring - rssBefore) / numThreads
+              << " bytes (plus 8 MiB of reserved stack address space each)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t numTasks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    if (numTasks == 0) {
+        std::cerr << "usage: " << argv[0] << " [number of benchmark tasks, > 0]" << std::endl;
+        return 1;
+    }
+    Executor ex(4);
+
+    for (int i = 0; i < 8; ++i)
+        ex.spawn(processTask(i, "Task description", i * 3.14));
+
+    Channel<int> channel;
+    ex.spawn(consumer(channel, 10));
+    ex.spawn(producers(channel));
+
+    int fds[2] = {-1, -1};
+    if (pipe(fds) == 0) {
+        ex.spawn(pipeReader(fds[0]));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        (void)!write(fds[1], "hello from main", 15);
+    }
+    ex.waitIdle();
+    for (int fd : fds)
+        if (fd != -1) close(fd);
+
+    benchmark(ex, numTasks);
+    threadBaseline(1000);
+    return 0;
+}
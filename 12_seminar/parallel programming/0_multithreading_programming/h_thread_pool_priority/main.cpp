@@ -0,0 +1,234 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+enum class Priority {
+    LatencyCritical = 0,
+    Normal = 1,
+    Background = 2
+};
+
+constexpr size_t numLanes = 3;
+
+struct PriorityOptions {
+    // Implicit deadline of a task submitted without one: enqueue time + budget.
+    // Equal budgets inside a lane keep plain FIFO order.
+    std::array<std::chrono::microseconds, numLanes> defaultBudget{
+        std::chrono::milliseconds(1), std::chrono::milliseconds(50), std::chrono::seconds(1)};
+    // Starvation protection: after this many dispatches from higher lanes while
+    // the lane had work waiting, the lane gets the next free worker.
+    std::array<unsigned, numLanes> starvationLimit{0, 8, 32};
+};
+
+class ThreadPool {
+public:
+    ThreadPool(size_t numThreads, PriorityOptions options = {}) : options(options), stop(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this] {
+                            return this->stop || this->pending > 0;
+                        });
+                        if (this->stop && this->pending == 0) return;
+                        task = this->popNext();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    // Same as before: normal priority, FIFO within the lane
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        enqueueWithPriority(Priority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template<class F, class... Args>
+    void enqueueWithPriority(Priority priority, F&& f, Args&&... args) {
+        Clock::time_point deadline = Clock::now() + options.defaultBudget[static_cast<size_t>(priority)];
+        enqueueWithDeadline(priority, deadline, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // Inside its lane the task is ordered earliest-deadline-first
+    template<class F, class... Args>
+    void enqueueWithDeadline(Priority priority, Clock::time_point deadline, F&& f, Args&&... args) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            lanes[static_cast<size_t>(priority)].push({deadline, sequence++, [task] { task(); }});
+            ++pending;
+        }
+        condition.notify_one();
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    struct Entry {
+        Clock::time_point deadline;
+        unsigned long long sequence;  // tie-break: submission order
+        std::function<void()> task;
+
+        bool operator>(const Entry& other) const {
+            if (deadline != other.deadline) return deadline > other.deadline;
+            return sequence > other.sequence;
+        }
+    };
+    using Lane = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+
+    // Called with queue_mutex held and at least one task pending
+    std::function<void()> popNext() {
+        size_t chosen = numLanes;
+        // a starved lower lane wins over the higher ones
+        for (size_t lane = numLanes; lane-- > 1;) {
+            if (!lanes[lane].empty() && skipped[lane] >= options.starvationLimit[lane]) {
+                chosen = lane;
+                break;
+            }
+        }
+        if (chosen == numLanes) {
+            for (size_t lane = 0; lane < numLanes; ++lane) {
+                if (!lanes[lane].empty()) {
+                    chosen = lane;
+                    break;
+                }
+            }
+        }
+        for (size_t lane = 0; lane < numLanes; ++lane) {
+            if (lane == chosen) skipped[lane] = 0;
+            else if (!lanes[lane].empty()) ++skipped[lane];
+        }
+
+        // priority_queue::top() is const, the entry is dropped right after the move
+        std::function<void()> task = std::move(const_cast<Entry&>(lanes[chosen].top()).task);
+        lanes[chosen].pop();
+        --pending;
+        return task;
+    }
+
+    std::vector<std::thread> workers;
+    std::array<Lane, numLanes> lanes;
+    std::array<unsigned, numLanes> skipped{};
+    size_t pending = 0;
+    unsigned long long sequence = 0;
+    PriorityOptions options;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+};
+
+// Busy work, so workers are really occupied (sleep_for would free the core)
+void spin(std::chrono::microseconds duration) {
+    auto end = Clock::now() + duration;
+    while (Clock::now() < end) {
+    }
+}
+
+struct Percentiles {
+    double p50, p99, max;
+};
+
+Percentiles percentiles(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    auto at = [&](double p) { return v[static_cast<size_t>(p * (v.size() - 1))]; };
+    return {at(0.5), at(0.99), v.back()};
+}
+
+// A saturating batch of background work plus a steady stream of short
+// latency-critical requests; prints the queueing delay of the requests
+void mixedWorkload(const char* name, bool usePriorities) {
+    const size_t numWorkers = 2;
+    const int numBatch = 4000, numNormal = 1000, numCritical = 200;
+
+    std::vector<double> criticalDelay(numCritical);
+    std::atomic<int> batchDone{0}, normalDone{0};
+    std::vector<double> batchFinish(numBatch);
+    auto start = Clock::now();
+    {
+        ThreadPool pool(numWorkers);
+        Priority batchLane = usePriorities ? Priority::Background : Priority::Normal;
+        Priority criticalLane = usePriorities ? Priority::LatencyCritical : Priority::Normal;
+
+        // the burst arrives first and fills the queue
+        for (int i = 0; i < numBatch; ++i)
+            pool.enqueueWithPriority(batchLane, [&, i] {
+                spin(std::chrono::microseconds(200));
+                batchFinish[i] = std::chrono::duration<double>(Clock::now() - start).count();
+                batchDone.fetch_add(1);
+            });
+        for (int i = 0; i < numNormal; ++i)
+            pool.enqueue([&] { spin(std::chrono::microseconds(100)); normalDone.fetch_add(1); });
+
+        // latency-critical requests trickle in while the pool is saturated;
+        // every fourth one carries an explicit tight deadline
+        for (int i = 0; i < numCritical; ++i) {
+            auto submitted = Clock::now();
+            auto record = [&criticalDelay, i, submitted] {
+                criticalDelay[i] = std::chrono::duration<double, std::micro>(Clock::now() - submitted).count();
+                spin(std::chrono::microseconds(20));
+            };
+            if (usePriorities && i % 4 == 0)
+                pool.enqueueWithDeadline(criticalLane, submitted + std::chrono::microseconds(200), record);
+            else
+                pool.enqueueWithPriority(criticalLane, record);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }   // destructor drains the remaining work
+
+    Percentiles p = percentiles(criticalDelay);
+    std::cout << name << "\n"
+              << "  latency-critical queueing delay p50/p99/max: "
+              << p.p50 << " / " << p.p99 << " / " << p.max << " us\n"
+              << "  background batch finished at "
+              << *std::max_element(batchFinish.begin(), batchFinish.end()) << " s ("
+              << batchDone.load() << " tasks), normal tasks done: " << normalDone.load() << "\n";
+}
+
+// Function with multiple parameters
+void processTask(int taskId, const std::string& message, double value) {
+    std::cout << "Starting task " << taskId
+              << " (" << message << ", " << value << ")"
+              << " on thread " << std::this_thread::get_id() << std::endl;
+}
+
+int main() {
+    {
+        ThreadPool pool(1);
+        // keep the only worker busy so the next three are queued together;
+        // the critical one runs first, the background one last
+        pool.enqueue([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+        pool.enqueueWithPriority(Priority::Background, processTask, 0, "background", 0.0);
+        pool.enqueue(processTask, 1, "normal", 3.14);
+        pool.enqueueWithPriority(Priority::LatencyCritical, processTask, 2, "latency-critical", 6.28);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::cout << "\nMixed workload (2 workers, 4000 x 200us batch + 1000 x 100us normal, "
+                 "200 x 20us critical every 2ms):\n";
+    mixedWorkload("single FIFO lane", false);
+    mixedWorkload("priority lanes + EDF", true);
+    return 0;
+}
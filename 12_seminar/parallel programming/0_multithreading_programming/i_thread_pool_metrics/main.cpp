@@ -0,0 +1,320 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+using Clock = std::chrono::steady_clock;
+
+inline uint64_t nanosSince(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+// Log-linear histogram in the spirit of HdrHistogram: every power of two is
+// split into 8 sub-buckets, so any value is stored with <= 12.5% error and
+// the whole range 0 .. 2^64 ns fits in 496 counters.
+class Histogram {
+public:
+    static constexpr int subBits = 3;
+    static constexpr int subBuckets = 1 << subBits;
+    static constexpr int numBuckets = (64 - subBits + 1) * subBuckets;
+
+    // Single writer (the owning worker), so a relaxed load + store is enough
+    // and no locked read-modify-write instruction is needed on the hot path
+    void record(uint64_t value) {
+        auto& c = counts[index(value)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static int index(uint64_t value) {
+        if (value < subBuckets) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int sub = static_cast<int>((value >> (exponent - subBits)) & (subBuckets - 1));
+        return (exponent - subBits + 1) * subBuckets + sub;
+    }
+
+    // Smallest value that maps to bucket i
+    static uint64_t lowerBound(int i) {
+        if (i < subBuckets) return i;
+        int exponent = i / subBuckets + subBits - 1;
+        uint64_t sub = i % subBuckets;
+        return (uint64_t(1) << exponent) | (sub << (exponent - subBits));
+    }
+
+    std::array<uint64_t, numBuckets> read() const {
+        std::array<uint64_t, numBuckets> result;
+        for (int i = 0; i < numBuckets; ++i)
+            result[i] = counts[i].load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, numBuckets> counts{};
+};
+
+// Merged, immutable copy of one or more histograms
+struct HistogramSnapshot {
+    std::array<uint64_t, Histogram::numBuckets> counts{};
+
+    void add(const std::array<uint64_t, Histogram::numBuckets>& other) {
+        for (int i = 0; i < Histogram::numBuckets; ++i) counts[i] += other[i];
+    }
+    uint64_t count() const {
+        uint64_t n = 0;
+        for (uint64_t c : counts) n += c;
+        return n;
+    }
+    // Value (lower bound of its bucket) below which a fraction p of the samples lie
+    uint64_t percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1, seen = 0;
+        for (int i = 0; i < Histogram::numBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return Histogram::lowerBound(i);
+        }
+        return Histogram::lowerBound(Histogram::numBuckets - 1);
+    }
+};
+
+struct WorkerSnapshot {
+    uint64_t completed;
+    double busySeconds;
+    double idleSeconds;
+};
+
+struct MetricsSnapshot {
+    uint64_t submitted;
+    uint64_t completed;
+    size_t queueDepth;
+    size_t queueHighWater;
+    HistogramSnapshot waitNanos;  // enqueue -> start
+    HistogramSnapshot runNanos;   // start -> end
+    std::vector<WorkerSnapshot> workers;
+};
+
+// EnableMetrics = false compiles every probe away; it exists to measure the overhead
+template<bool EnableMetrics>
+class BasicThreadPool {
+public:
+    // Counters are exact; the wait/run histograms time one task in `sampleEvery`
+    // (rounded up to a power of two), because two clock reads per task would
+    // cost more than a tiny task itself. Busy time is extrapolated from the
+    // same samples, so parking and waking up read no clock either.
+    BasicThreadPool(size_t numThreads, uint64_t sampleEvery = 16)
+        : epoch(Clock::now()), stop(false) {
+        while (sampleMask + 1 < sampleEvery)
+            sampleMask = sampleMask * 2 + 1;
+        for (size_t i = 0; i < numThreads; ++i)
+            stats.emplace_back(new WorkerStats);
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this, i] {
+                WorkerStats& my = *this->stats[i];
+                while (true) {
+                    std::function<void()> task;
+                    Clock::time_point enqueued{};  // stays zero for tasks that are not sampled
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this] { return this->stop || !this->tasks.empty(); });
+                        if (this->stop && this->tasks.empty()) return;
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                        // the queue is FIFO, so the n-th task taken is the n-th submitted
+                        if constexpr (EnableMetrics) {
+                            if ((this->dequeued++ & this->sampleMask) == 0) {
+                                enqueued = this->sampleTimes.front();
+                                this->sampleTimes.pop();
+                            }
+                        }
+                    }
+                    if constexpr (EnableMetrics) {
+                        if (enqueued != Clock::time_point{}) {
+                            Clock::time_point start = Clock::now();
+                            task();
+                            Clock::time_point end = Clock::now();
+                            my.wait.record(nanosSince(enqueued, start));
+                            my.run.record(nanosSince(start, end));
+                            WorkerStats::add(my.sampled, 1);
+                            WorkerStats::add(my.sampledRunNanos, nanosSince(start, end));
+                        } else {
+                            task();
+                        }
+                        WorkerStats::add(my.completed, 1);
+                    } else {
+                        task();
+                    }
+                }
+            });
+        }
+    }
+
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace([task] { task(); });
+            if constexpr (EnableMetrics) {
+                // the enqueue time of a sampled task goes to a side queue, so
+                // the task queue stays a plain std::function queue
+                if ((submitted++ & sampleMask) == 0)
+                    sampleTimes.push(Clock::now());
+                queueHighWater = std::max(queueHighWater, tasks.size());
+            }
+        }
+        condition.notify_one();
+    }
+
+    // Consistent enough for monitoring: the queue fields are read under the
+    // queue lock (a snapshot is rare, enqueue is not), the worker fields
+    // atomically; the pool keeps running, so counters may move meanwhile
+    MetricsSnapshot snapshot() const {
+        MetricsSnapshot s{};
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            s.submitted = submitted;
+            s.queueDepth = tasks.size();
+            s.queueHighWater = queueHighWater;
+        }
+        uint64_t now = nanosSince(epoch, Clock::now());
+        for (const auto& w : stats) {
+            s.waitNanos.add(w->wait.read());
+            s.runNanos.add(w->run.read());
+            uint64_t completed = w->completed.load(std::memory_order_relaxed);
+            uint64_t sampled = w->sampled.load(std::memory_order_relaxed);
+            uint64_t sampledRun = w->sampledRunNanos.load(std::memory_order_relaxed);
+            // busy = mean run time of the sampled tasks * tasks completed
+            uint64_t busy = sampled ? std::min<uint64_t>(now, double(sampledRun) / sampled * completed) : 0;
+            s.completed += completed;
+            s.workers.push_back({completed, busy * 1e-9, (now - busy) * 1e-9});
+        }
+        return s;
+    }
+
+    ~BasicThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    // Written only by its worker; one cache line apart from its neighbours so
+    // workers never invalidate each other's counters
+    struct alignas(64) WorkerStats {
+        Histogram wait;
+        Histogram run;
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> sampled{0};
+        std::atomic<uint64_t> sampledRunNanos{0};
+
+        static void add(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+    Clock::time_point epoch;
+    uint64_t sampleMask = 0;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerStats>> stats;
+    std::queue<std::function<void()>> tasks;
+    mutable std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+
+    // guarded by queue_mutex
+    uint64_t submitted = 0;
+    uint64_t dequeued = 0;
+    size_t queueHighWater = 0;
+    std::queue<Clock::time_point> sampleTimes;  // enqueue times of the sampled tasks still queued
+};
+
+using ThreadPool = BasicThreadPool<true>;
+
+void printSnapshot(const MetricsSnapshot& s) {
+    std::cout << "  submitted " << s.submitted << ", completed " << s.completed
+              << ", queue depth " << s.queueDepth << " (high-water " << s.queueHighWater << ")\n"
+              << "  wait ns p50/p99/p99.9: " << s.waitNanos.percentile(0.5) << " / "
+              << s.waitNanos.percentile(0.99) << " / " << s.waitNanos.percentile(0.999) << "\n"
+              << "  run  ns p50/p99/p99.9: " << s.runNanos.percentile(0.5) << " / "
+              << s.runNanos.percentile(0.99) << " / " << s.runNanos.percentile(0.999) << "\n";
+    for (size_t i = 0; i < s.workers.size(); ++i) {
+        const auto& w = s.workers[i];
+        double total = w.busySeconds + w.idleSeconds;
+        std::cout << "  worker " << i << ": " << w.completed << " tasks, busy "
+                  << (total > 0 ? 100.0 * w.busySeconds / total : 0.0) << "%\n";
+    }
+}
+
+// Fine-grained tasks (a few hundred ns each): the worst case for instrumentation
+template<bool EnableMetrics>
+double fineGrained(size_t numTasks) {
+    std::atomic<uint64_t> sink{0};
+    auto start = Clock::now();
+    {
+        BasicThreadPool<EnableMetrics> pool(2);
+        for (size_t i = 0; i < numTasks; ++i)
+            pool.enqueue([&sink, i] {
+                uint64_t x = i;
+                for (int k = 0; k < 50; ++k) x = x * 6364136223846793005ull + 1442695040888963407ull;
+                sink.fetch_add(x & 1, std::memory_order_relaxed);
+            });
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main() {
+    {
+        ThreadPool pool(4, 1);  // few, long tasks: time every one of them
+        for (int i = 0; i < 40; ++i)
+            pool.enqueue([i] { std::this_thread::sleep_for(std::chrono::milliseconds(5 + i % 10)); });
+
+        // sample while the pool is running, as a monitoring thread would
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        std::cout << "Snapshot while running:\n";
+        printSnapshot(pool.snapshot());
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::cout << "Snapshot after the queue drained:\n";
+        printSnapshot(pool.snapshot());
+    }
+
+    // The run-to-run noise of this benchmark is larger than the overhead, so
+    // run both variants back to back in alternating order and report the
+    // median of the per-pair ratios as well as the best times
+    const size_t numTasks = 1000000;
+    const int pairs = 21;
+    double plain = 1e30, instrumented = 1e30;
+    std::vector<double> ratios;
+    for (int rep = 0; rep < pairs; ++rep) {
+        double off, on;
+        if (rep % 2 == 0) {
+            off = fineGrained<false>(numTasks);
+            on = fineGrained<true>(numTasks);
+        } else {
+            on = fineGrained<true>(numTasks);
+            off = fineGrained<false>(numTasks);
+        }
+        plain = std::min(plain, off);
+        instrumented = std::min(instrumented, on);
+        ratios.push_back(on / off);
+    }
+    std::nth_element(ratios.begin(), ratios.begin() + pairs / 2, ratios.end());
+    std::cout << "\nFine-grained benchmark, " << numTasks << " tasks, " << pairs << " pairs:\n"
+              << "  without metrics, best: " << plain << " s\n"
+              << "  with metrics, best:    " << instrumented << " s\n"
+              << "  overhead, best:        " << 100.0 * (instrumented - plain) / plain << "%\n"
+              << "  overhead, median pair: " << 100.0 * (ratios[pairs / 2] - 1) << "%" << std::endl;
+    return 0;
+}
@@ -0,0 +1,310 @@
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Tell the core we are in a spin loop: saves power and frees pipeline
+// resources for the SMT sibling
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+struct SpinOptions {
+    // Spinning only helps if the thread that makes the condition true can run
+    // at the same time, so on a single cpu the default is to skip it
+    unsigned spinIterations = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+    unsigned yieldIterations = 8;
+};
+
+// Spin, then yield, then park on a futex (an "event count").
+//
+// Waiter:   parked++ -> re-check condition -> futex_wait(epoch, seen)
+// Notifier: change state -> epoch++ -> if (parked) futex_wake(epoch)
+// All four steps are seq_cst, so either the waiter sees the new state or the
+// notifier sees parked > 0; no wake-up can get lost, and notify costs no
+// syscall at all while nobody is parked.
+class AdaptiveWaiter {
+public:
+    explicit AdaptiveWaiter(SpinOptions options = {}) : options(options) {}
+
+    template<class Predicate>
+    void wait(Predicate ready) {
+        for (unsigned i = 0; i < options.spinIterations; ++i) {
+            if (ready()) return;
+            cpuRelax();
+        }
+        for (unsigned i = 0; i < options.yieldIterations; ++i) {
+            if (ready()) return;
+            std::this_thread::yield();
+        }
+        while (!ready()) {
+            uint32_t seen = epoch.load();
+            parked.fetch_add(1);
+            if (!ready())
+                futexWait(seen);
+            parked.fetch_sub(1);
+        }
+    }
+
+    void notifyOne() { notify(1); }
+    void notifyAll() { notify(INT32_MAX); }
+
+    uint64_t wakeSyscalls() const { return wakes.load(std::memory_order_relaxed); }
+
+private:
+    void notify(int count) {
+        epoch.fetch_add(1);
+        if (parked.load() > 0) {
+            wakes.fetch_add(1, std::memory_order_relaxed);
+            futexWake(count);
+        }
+    }
+
+#ifdef __linux__
+    void futexWait(uint32_t seen) {
+        // returns at once if epoch != seen, i.e. a notify slipped in meanwhile
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+    }
+    void futexWake(int count) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+#else
+    // Portable fallback with the same protocol
+    void futexWait(uint32_t seen) {
+        std::unique_lock<std::mutex> lock(park_mutex);
+        park.wait(lock, [&] { return epoch.load() != seen; });
+    }
+    void futexWake(int) {
+        { std::lock_guard<std::mutex> lock(park_mutex); }
+        park.notify_all();
+    }
+    std::mutex park_mutex;
+    std::condition_variable park;
+#endif
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<int> parked{0};
+    std::atomic<uint64_t> wakes{0};
+    SpinOptions options;
+};
+
+// d_thread_pool with the condition variable replaced by AdaptiveWaiter.
+// The queue is still protected by a mutex; `queued` lets idle workers poll
+// for work without touching that mutex.
+class ThreadPool {
+public:
+    ThreadPool(size_t numThreads, SpinOptions options = {}) : waiter(options), stop(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    this->waiter.wait([this] {
+                        return this->stop.load() || this->queued.load() > 0;
+                    });
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        if (this->tasks.empty()) {
+                            if (this->stop) return;
+                            continue;  // another worker got it first
+                        }
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                        this->queued.fetch_sub(1);
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace([task] { task(); });
+            queued.fetch_add(1);
+        }
+        waiter.notifyOne();  // no syscall unless a worker is parked
+    }
+
+    uint64_t wakeSyscalls() const { return waiter.wakeSyscalls(); }
+
+    ~ThreadPool() {
+        stop = true;
+        waiter.notifyAll();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::atomic<size_t> queued{0};
+    std::mutex queue_mutex;
+    AdaptiveWaiter waiter;
+    std::atomic<bool> stop;
+};
+
+// Unchanged pool from d_thread_pool, as the baseline
+class CondVarThreadPool {
+public:
+    CondVarThreadPool(size_t numThreads) : stop(false) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(this->queue_mutex);
+                        this->condition.wait(lock, [this] {
+                            return this->stop || !this->tasks.empty();
+                        });
+                        if (this->stop && this->tasks.empty()) return;
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    template<class F, class... Args>
+    void enqueue(F&& f, Args&&... args) {
+        auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            tasks.emplace([task] { task(); });
+        }
+        condition.notify_one();
+    }
+
+    ~CondVarThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+};
+
+// The c_2 producer/consumer with consumers waiting on an AdaptiveWaiter
+void producerConsumer() {
+    std::queue<int> shared_queue;
+    std::mutex mtx;
+    std::atomic<size_t> available{0};
+    AdaptiveWaiter notEmpty;
+
+    auto producer = [&](int id) {
+        for (int i = 0; i < 10; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                shared_queue.push(id * 100 + i);
+                available.fetch_add(1);
+            }
+            notEmpty.notifyOne();
+        }
+    };
+    auto consumer = [&](int id) {
+        int sum = 0;
+        for (int received = 0; received < 10;) {
+            notEmpty.wait([&] { return available.load() > 0; });
+            std::lock_guard<std::mutex> lock(mtx);
+            if (shared_queue.empty()) continue;
+            sum += shared_queue.front();
+            shared_queue.pop();
+            available.fetch_sub(1);
+            ++received;
+        }
+        std::cout << "Consumer " << id << " consumed 10 items, sum " << sum << std::endl;
+    };
+
+    std::thread producers[2], consumers[2];
+    for (int i = 0; i < 2; ++i) consumers[i] = std::thread(consumer, i + 1);
+    for (int i = 0; i < 2; ++i) producers[i] = std::thread(producer, i + 1);
+    for (int i = 0; i < 2; ++i) producers[i].join();
+    for (int i = 0; i < 2; ++i) consumers[i].join();
+    std::cout << "futex wake syscalls: " << notEmpty.wakeSyscalls() << " for 20 notifies" << std::endl;
+}
+
+// Submit one task to an idle pool, measure until it starts, let the pool go
+// idle for `gap`, repeat
+template<class Pool>
+void submitToStart(const char* name, Pool& pool, std::chrono::microseconds gap, int rounds) {
+    std::vector<double> latency;
+    for (int i = 0; i < rounds; ++i) {
+        std::atomic<bool> done{false};
+        Clock::time_point started;
+        Clock::time_point submitted = Clock::now();
+        pool.enqueue([&] {
+            started = Clock::now();
+            done.store(true, std::memory_order_release);
+        });
+        while (!done.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        latency.push_back(std::chrono::duration<double, std::micro>(started - submitted).count());
+        if (gap.count() > 0)
+            std::this_thread::sleep_for(gap);
+    }
+    std::sort(latency.begin(), latency.end());
+    std::cout << "  " << name << ": p50 " << latency[latency.size() / 2]
+              << " us, p99 " << latency[latency.size() * 99 / 100] << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    producerConsumer();
+
+    SpinOptions options;
+    if (argc > 1) options.spinIterations = std::stoul(argv[1]);
+    if (argc > 2) options.yieldIterations = std::stoul(argv[2]);
+    std::cout << "\nSubmit-to-start latency, 2 workers, spin budget "
+              << options.spinIterations << " pauses + " << options.yieldIterations << " yields\n";
+    const int rounds = 2000;
+    for (auto gap : {std::chrono::microseconds(0), std::chrono::microseconds(20),
+                     std::chrono::microseconds(1000)}) {
+        std::cout << "idle gap between submits: " << gap.count() << " us\n";
+        {
+            CondVarThreadPool pool(2);
+            submitToStart("condition_variable", pool, gap, rounds);
+        }
+        {
+            ThreadPool pool(2, options);
+            submitToStart("spin-then-park    ", pool, gap, rounds);
+            std::cout << "    futex wake syscalls: " << pool.wakeSyscalls() << " for " << rounds << " submits\n";
+        }
+    }
+    return 0;
+}
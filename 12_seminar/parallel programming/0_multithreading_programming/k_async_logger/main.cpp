@@ -0,0 +1,398 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <ctime>
+
+using Clock = std::chrono::steady_clock;
+
+// What the caller writes: no formatting, no allocation, no lock
+struct LogRecord {
+    static constexpr int maxArgs = 5;
+    enum ArgType : uint8_t { Int, UInt, Double, CString };
+
+    uint64_t timestamp;          // steady_clock nanoseconds
+    uint16_t formatId;           // index into the format registry
+    uint16_t threadId;           // small id assigned when the thread first logs
+    uint8_t argc;
+    uint8_t types[maxArgs];
+    uint64_t args[maxArgs];      // raw bits of each argument
+};
+
+enum class OverflowPolicy {
+    Drop,   // never block the caller; count the lost records
+    Block   // wait for the background thread to make room
+};
+
+// Single-producer / single-consumer ring: the owning thread writes, the
+// background thread reads. head and tail live on separate cache lines.
+class RingBuffer {
+public:
+    RingBuffer(size_t capacityPow2, uint16_t threadId)
+        : threadId(threadId), mask(capacityPow2 - 1), records(capacityPow2) {}
+
+    bool tryPush(const LogRecord& r) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) return false;
+        }
+        records[t & mask] = r;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: append everything available to `out`
+    size_t drain(std::vector<LogRecord>& out) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        for (uint64_t i = h; i != t; ++i)
+            out.push_back(records[i & mask]);
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> ownerAlive{true};
+    const uint16_t threadId;
+
+private:
+    const uint64_t mask;
+    std::vector<LogRecord> records;
+    alignas(64) std::atomic<uint64_t> tail{0};
+    uint64_t cachedHead = 0;                     // producer's last view of head
+    alignas(64) std::atomic<uint64_t> head{0};
+};
+
+class AsyncLogger {
+public:
+    struct Options {
+        size_t bufferRecords = 1 << 14;          // per thread, power of two
+        OverflowPolicy overflow = OverflowPolicy::Drop;
+        std::chrono::microseconds idleSleep{500};
+    };
+
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    // Call while no other thread is logging (buffers created earlier keep their size)
+    void configure(const Options& o, const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        options = o;
+        if (out && out != stdout) std::fclose(out);
+        out = path.empty() ? stdout : std::fopen(path.c_str(), "w");
+        if (!out) out = stdout;
+    }
+
+    uint16_t registerFormat(const char* format) {
+        std::lock_guard<std::mutex> lock(mutex);
+        formats.push_back(format);
+        return static_cast<uint16_t>(formats.size() - 1);
+    }
+
+    template<class... Args>
+    void log(uint16_t formatId, Args... args) {
+        static_assert(sizeof...(Args) <= LogRecord::maxArgs, "too many log arguments");
+        LogRecord r;
+        r.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+        r.formatId = formatId;
+        r.argc = 0;
+        (encode(r, args), ...);
+
+        RingBuffer& buffer = localBuffer();
+        r.threadId = buffer.threadId;
+        if (buffer.tryPush(r)) return;
+        if (options.overflow == OverflowPolicy::Drop) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        while (!buffer.tryPush(r))
+            std::this_thread::yield();
+    }
+
+    // Wait until everything logged so far is written
+    void flush() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                bool allEmpty = std::all_of(buffers.begin(), buffers.end(),
+                                            [](const auto& b) { return b->empty(); });
+                if (allEmpty && !writing) break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        std::fflush(out);
+    }
+
+    uint64_t droppedTotal() {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t n = retiredDropped;
+        for (const auto& b : buffers) n += b->dropped.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    ~AsyncLogger() {
+        running = false;
+        background.join();
+        if (out && out != stdout) std::fclose(out);
+    }
+
+private:
+    AsyncLogger() : out(stdout), start(Clock::now()) {
+        background = std::thread([this] { backgroundLoop(); });
+    }
+
+    template<class T>
+    static void encode(LogRecord& r, T value) {
+        uint8_t i = r.argc++;
+        if constexpr (std::is_floating_point_v<T>) {
+            double d = value;
+            std::memcpy(&r.args[i], &d, sizeof(d));
+            r.types[i] = LogRecord::Double;
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            r.args[i] = static_cast<uint64_t>(static_cast<int64_t>(value));
+            r.types[i] = LogRecord::Int;
+        } else if constexpr (std::is_integral_v<T>) {
+            r.args[i] = static_cast<uint64_t>(value);
+            r.types[i] = LogRecord::UInt;
+        } else {
+            // only the pointer is stored: pass string literals or strings that outlive the logger
+            static_assert(std::is_convertible_v<T, const char*>, "unsupported log argument type");
+            r.args[i] = reinterpret_cast<uint64_t>(static_cast<const char*>(value));
+            r.types[i] = LogRecord::CString;
+        }
+    }
+
+    // The buffer is created on the first log call of each thread. The logger
+    // shares ownership, so records of a thread that already exited still get written.
+    RingBuffer& localBuffer() {
+        struct Holder {
+            std::shared_ptr<RingBuffer> buffer;
+            ~Holder() { if (buffer) buffer->ownerAlive = false; }
+        };
+        thread_local Holder holder;
+        if (!holder.buffer) {
+            std::lock_guard<std::mutex> lock(mutex);
+            holder.buffer = std::make_shared<RingBuffer>(options.bufferRecords, nextThreadId++);
+            buffers.push_back(holder.buffer);
+        }
+        return *holder.buffer;
+    }
+
+    void format(std::string& line, const LogRecord& r, const char* fmt) {
+        char tmp[64];
+        double seconds = (r.timestamp - std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              start.time_since_epoch()).count()) * 1e-9;
+        std::snprintf(tmp, sizeof(tmp), "[%12.6f] [T%u] ", seconds, r.threadId);
+        line += tmp;
+        int arg = 0;
+        for (const char* p = fmt; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}' && arg < r.argc) {
+                uint64_t bits = r.args[arg];
+                switch (r.types[arg]) {
+                case LogRecord::Int: std::snprintf(tmp, sizeof(tmp), "%lld", static_cast<long long>(bits)); break;
+                case LogRecord::UInt: std::snprintf(tmp, sizeof(tmp), "%llu", static_cast<unsigned long long>(bits)); break;
+                case LogRecord::Double: {
+                    double d;
+                    std::memcpy(&d, &bits, sizeof(d));
+                    std::snprintf(tmp, sizeof(tmp), "%g", d);
+                    break;
+                }
+                case LogRecord::CString: line += reinterpret_cast<const char*>(bits); tmp[0] = '\0'; break;
+                }
+                line += tmp;
+                ++arg;
+                ++p;
+            } else {
+                line += *p;
+            }
+        }
+        line += '\n';
+    }
+
+    // Drain all rings, merge by timestamp, format and write with one fwrite per batch
+    void backgroundLoop() {
+        std::vector<LogRecord> batch;
+        std::string text;
+        while (true) {
+            bool stopping = !running.load();
+            std::vector<std::shared_ptr<RingBuffer>> snapshot;
+            std::vector<const char*> fmts;
+            std::chrono::microseconds idleSleep;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                writing = true;
+                idleSleep = options.idleSleep;
+                snapshot = buffers;
+            }
+
+            batch.clear();
+            uint64_t dropped = 0;
+            for (auto& b : snapshot) {
+                b->drain(batch);
+                dropped += b->dropped.exchange(0, std::memory_order_relaxed);
+            }
+            // copy the formats only after draining: a call site registers its
+            // format before pushing, so every drained formatId is in the copy
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                fmts.assign(formats.begin(), formats.end());
+            }
+            std::sort(batch.begin(), batch.end(),
+                      [](const LogRecord& a, const LogRecord& b) { return a.timestamp < b.timestamp; });
+
+            text.clear();
+            if (dropped > 0)
+                text += "[logger] " + std::to_string(dropped) + " records dropped (buffer full)\n";
+            for (const auto& r : batch)
+                format(text, r, fmts[r.formatId]);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!text.empty()) std::fwrite(text.data(), 1, text.size(), out);
+                retiredDropped += dropped;
+                // forget buffers of exited threads once they are empty
+                buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const auto& b) {
+                                  return !b->ownerAlive && b->empty();
+                              }), buffers.end());
+                writing = false;
+            }
+            if (stopping) {
+                std::fflush(out);
+                return;
+            }
+            if (batch.empty())
+                std::this_thread::sleep_for(idleSleep);
+        }
+    }
+
+    std::mutex mutex;                            // registration and the FILE*, never taken by log()
+    std::vector<std::shared_ptr<RingBuffer>> buffers;
+    std::deque<const char*> formats;
+    uint16_t nextThreadId = 0;
+    uint64_t retiredDropped = 0;
+    bool writing = false;
+    Options options;
+    std::FILE* out;
+    Clock::time_point start;
+    std::atomic<bool> running{true};
+    std::thread background;
+};
+
+// The format string is registered once per call site; afterwards a log call
+// only copies its arguments into the calling thread's ring buffer
+#define LOG(fmt, ...)                                                                   \
+    do {                                                                                \
+        static const uint16_t logFormatId_ = AsyncLogger::instance().registerFormat(fmt); \
+        AsyncLogger::instance().log(logFormatId_, ##__VA_ARGS__);                       \
+    } while (0)
+
+// --- the matrix multiplication worker from the threading examples ---
+void matrixMultiplication(int steps) {
+    LOG("Matrix multiplication started, {} steps", steps);
+    for (int i = 0; i < steps; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        LOG("Matrix multiplication in progress... step {} of {} ({}%)", i + 1, steps, 100.0 * (i + 1) / steps);
+    }
+    LOG("Matrix multiplication {}", "completed!");
+}
+
+// --- benchmark ---
+std::mutex coutLikeMutex;
+
+// CPU time of the calling thread: the cost a log call adds to the worker,
+// independent of how many cores the threads share
+double threadCpuNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+template<class Body>
+double nanosPerCall(int numThreads, int callsPerThread, Body body) {
+    std::vector<std::thread> threads;
+    std::vector<double> perThread(numThreads);
+    for (int t = 0; t < numThreads; ++t)
+        threads.emplace_back([&, t] {
+            double s = threadCpuNanos();
+            for (int i = 0; i < callsPerThread; ++i) body(t, i);
+            perThread[t] = (threadCpuNanos() - s) / callsPerThread;
+        });
+    for (auto& th : threads) th.join();
+    double sum = 0;
+    for (double v : perThread) sum += v;
+    return sum / numThreads;
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    AsyncLogger& logger = AsyncLogger::instance();
+    logger.configure({}, "");  // stdout for the demo
+
+    std::thread t1(matrixMultiplication, 3);
+    std::thread t2(matrixMultiplication, 2);
+    t1.join();
+    t2.join();
+    logger.flush();
+
+    // Caller-side cost, 4 threads x 200k calls each
+    const int threads = 4, calls = 200000;
+    AsyncLogger::Options big;
+    big.bufferRecords = 1 << 16;  // 4 MiB per thread
+    big.overflow = OverflowPolicy::Block;
+    logger.configure(big, dir + "/async_logger_bench.log");
+    double asyncNs = nanosPerCall(threads, calls, [](int t, int i) {
+        LOG("worker {} step {} value {}", t, i, i * 0.5);
+    });
+    logger.flush();
+
+    std::ofstream stream(dir + "/ostream_bench.log");
+    double streamNs = nanosPerCall(threads, calls, [&](int t, int i) {
+        std::lock_guard<std::mutex> lock(coutLikeMutex);
+        stream << "worker " << t << " step " << i << " value " << i * 0.5 << std::endl;
+    });
+
+    std::cout << "\nCPU time per log call in the calling thread (" << threads << " threads):\n"
+              << "  std::ostream + mutex + std::endl: " << streamNs << " ns\n"
+              << "  async logger:                     " << asyncNs << " ns" << std::endl;
+
+    // Overflow: a burst much larger than a small ring
+    for (OverflowPolicy policy : {OverflowPolicy::Drop, OverflowPolicy::Block}) {
+        AsyncLogger::Options small;
+        small.bufferRecords = 1 << 10;
+        small.overflow = policy;
+        logger.configure(small, dir + "/async_logger_overflow.log");
+        uint64_t droppedBefore = logger.droppedTotal();
+        double ns = 0;
+        std::thread burst([&] {
+            double s = threadCpuNanos();
+            for (int i = 0; i < 200000; ++i) LOG("burst {}", i);
+            ns = (threadCpuNanos() - s) / 200000;
+        });
+        burst.join();
+        logger.flush();
+        std::cout << (policy == OverflowPolicy::Drop ? "  overflow=Drop:  " : "  overflow=Block: ")
+                  << ns << " ns per call, " << logger.droppedTotal() - droppedBefore
+                  << " of 200000 records dropped" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One plane of an image, rows stored contiguously. A colour image is a set of
+// planes (planar layout), e.g. std::vector<Image<uint8_t>> for R, G and B.
+template<class T>
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<T> data;
+
+    Image() = default;
+    Image(int width, int height) : width(width), height(height), data(size_t(width) * height) {}
+
+    T* row(int y) { return data.data() + size_t(y) * width; }
+    const T* row(int y) const { return data.data() + size_t(y) * width; }
+};
+
+using ImageU8 = Image<uint8_t>;
+using ImageF32 = Image<float>;
+
+// All kernels write a new image and then swap it into dst, so dst may be
+// the same object as src, e.g. gaussianBlur5(img, img).
+
+// How a kernel runs: the image is cut into strips of rows that are handed out
+// to `threads` threads; `simd` selects the SSE2 inner loops, otherwise the
+// scalar reference loops are used.
+struct ExecOptions {
+    int threads = 1;
+    bool simd = true;
+};
+
+// Separable 5x5 Gaussian, kernel [1 4 6 4 1] / 16 in each direction, edges clamped.
+// The 8-bit version is integer only, so SIMD and scalar results are bit-identical.
+void gaussianBlur5(const ImageU8& src, ImageU8& dst, const ExecOptions& options = {});
+void gaussianBlur5(const ImageF32& src, ImageF32& dst, const ExecOptions& options = {});
+
+// Separable box blur of size (2 * radius + 1)^2, edges clamped
+void boxBlur(const ImageF32& src, ImageF32& dst, int radius, const ExecOptions& options = {});
+
+// Sobel gradient magnitude |gx| + |gy|; the 8-bit version saturates at 255
+void sobel(const ImageU8& src, ImageU8& dst, const ExecOptions& options = {});
+void sobel(const ImageF32& src, ImageF32& dst, const ExecOptions& options = {});
+
+// Bilinear resize to dst.width x dst.height (dst must be sized by the caller).
+// The 8-bit version uses 8-bit fixed-point weights.
+void resizeBilinear(const ImageU8& src, ImageU8& dst, const ExecOptions& options = {});
+void resizeBilinear(const ImageF32& src, ImageF32& dst, const ExecOptions& options = {});
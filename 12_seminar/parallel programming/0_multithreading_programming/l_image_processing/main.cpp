@@ -0,0 +1,172 @@
+#include "image_processing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Synthetic test image: gradients, a few sharp edges and noise
+ImageU8 makeImage(int width, int height) {
+    ImageU8 img(width, height);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> noise(-20, 20);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x) {
+            int v = (x * 255) / width / 2 + (y * 255) / height / 2;
+            if ((x / 64 + y / 64) % 2) v = 255 - v;
+            img.row(y)[x] = uint8_t(std::clamp(v + noise(rng), 0, 255));
+        }
+    return img;
+}
+
+ImageF32 toFloat(const ImageU8& img) {
+    ImageF32 out(img.width, img.height);
+    std::transform(img.data.begin(), img.data.end(), out.data.begin(), [](uint8_t v) { return v / 255.0f; });
+    return out;
+}
+
+// The pipeline of the original example (blur -> edges -> downscale), per plane
+std::vector<ImageU8> imageProcessing(const std::vector<ImageU8>& planes, const ExecOptions& options) {
+    std::vector<ImageU8> result;
+    for (const auto& plane : planes) {
+        ImageU8 blurred, edges, small(plane.width / 2, plane.height / 2);
+        gaussianBlur5(plane, blurred, options);
+        sobel(blurred, edges, options);
+        resizeBilinear(edges, small, options);
+        result.push_back(std::move(small));
+    }
+    return result;
+}
+
+// ------------------------------------------------------------ validation
+template<class T>
+double maxDiff(const Image<T>& a, const Image<T>& b) {
+    double d = 0;
+    for (size_t i = 0; i < a.data.size(); ++i)
+        d = std::max(d, std::fabs(double(a.data[i]) - double(b.data[i])));
+    return d;
+}
+
+// SIMD and scalar results must be bit-identical; returns false on any mismatch
+bool validate() {
+    // odd sizes exercise the scalar tails and partial strips
+    ImageU8 u8 = makeImage(517, 333);
+    ImageF32 f32 = toFloat(u8);
+    ExecOptions scalar{1, false}, vector{3, true};
+
+    bool ok = true;
+    auto check = [&ok](const char* name, double diff, const char* what = "simd - scalar") {
+        std::cout << "  " << name << ": max |" << what << "| = " << diff << (diff == 0 ? "  ok" : "  MISMATCH") << '\n';
+        ok = ok && diff == 0;
+    };
+    {
+        ImageU8 a, b;
+        gaussianBlur5(u8, a, scalar);
+        gaussianBlur5(u8, b, vector);
+        check("gaussianBlur5 u8 ", maxDiff(a, b));
+        sobel(u8, a, scalar);
+        sobel(u8, b, vector);
+        check("sobel u8         ", maxDiff(a, b));
+        ImageU8 c(301, 170), d(301, 170);
+        resizeBilinear(u8, c, scalar);
+        resizeBilinear(u8, d, vector);
+        check("resizeBilinear u8", maxDiff(c, d));
+    }
+    {
+        ImageF32 a, b;
+        gaussianBlur5(f32, a, scalar);
+        gaussianBlur5(f32, b, vector);
+        check("gaussianBlur5 f32", maxDiff(a, b));
+        boxBlur(f32, a, 3, scalar);
+        boxBlur(f32, b, 3, vector);
+        check("boxBlur(3) f32   ", maxDiff(a, b));
+        sobel(f32, a, scalar);
+        sobel(f32, b, vector);
+        check("sobel f32        ", maxDiff(a, b));
+        ImageF32 c(301, 170), d(301, 170);
+        resizeBilinear(f32, c, scalar);
+        resizeBilinear(f32, d, vector);
+        check("resizeBilinear f32", maxDiff(c, d));
+    }
+    // a flat image must stay flat
+    ImageU8 flat(64, 48), out(100, 70);
+    std::fill(flat.data.begin(), flat.data.end(), 200);
+    resizeBilinear(flat, out, vector);
+    ImageU8 blurred;
+    gaussianBlur5(flat, blurred, vector);
+    auto [outMin, outMax] = std::minmax_element(out.data.begin(), out.data.end());
+    auto [blurMin, blurMax] = std::minmax_element(blurred.data.begin(), blurred.data.end());
+    bool flatOk = *outMin == 200 && *outMax == 200 && *blurMin == 200 && *blurMax == 200;
+    std::cout << "  flat 200 -> resize " << int(*outMin) << ".." << int(*outMax) << ", blur " << int(*blurMin)
+              << ".." << int(*blurMax) << (flatOk ? "  ok" : "  MISMATCH") << '\n';
+
+    // src and dst may be the same image
+    ImageU8 inPlace = u8, expected;
+    gaussianBlur5(u8, expected, vector);
+    gaussianBlur5(inPlace, inPlace, vector);
+    check("gaussianBlur5(img, img) u8", maxDiff(inPlace, expected), "in place - out of place");
+    return ok && flatOk;
+}
+
+// ------------------------------------------------------------ benchmark
+double megapixelsPerSecond(int pixels, const std::function<void()>& kernel) {
+    kernel(); // warm-up, also allocates dst
+    int runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        kernel();
+        ++runs;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.5);
+    return pixels * double(runs) / elapsed.count() / 1e6;
+}
+
+void benchmark(int width, int height) {
+    ImageU8 u8 = makeImage(width, height);
+    ImageF32 f32 = toFloat(u8);
+    int hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threadCounts = {1, 2, 4};
+    if (hw > 4) threadCounts.push_back(hw);
+
+    std::cout << "\nThroughput in MP/s, " << width << "x" << height << " (hardware threads: " << hw << ")\n";
+    std::cout << "kernel             simd  threads:";
+    for (int t : threadCounts) std::cout << '\t' << t;
+    std::cout << '\n';
+
+    auto row = [&](const char* name, auto makeKernel) {
+        for (bool simd : {false, true}) {
+            std::cout << name << (simd ? "  on " : "  off") << "          ";
+            for (int t : threadCounts)
+                std::cout << '\t' << int(megapixelsPerSecond(width * height, makeKernel(ExecOptions{t, simd})));
+            std::cout << std::endl;
+        }
+    };
+    ImageU8 dstU8, smallU8(width / 2, height / 2);
+    ImageF32 dstF32;
+    row("gaussianBlur5 u8 ", [&](ExecOptions o) { return [&, o] { gaussianBlur5(u8, dstU8, o); }; });
+    row("gaussianBlur5 f32", [&](ExecOptions o) { return [&, o] { gaussianBlur5(f32, dstF32, o); }; });
+    row("boxBlur(3) f32   ", [&](ExecOptions o) { return [&, o] { boxBlur(f32, dstF32, 3, o); }; });
+    row("sobel u8         ", [&](ExecOptions o) { return [&, o] { sobel(u8, dstU8, o); }; });
+    row("resize 1/2 u8    ", [&](ExecOptions o) { return [&, o] { resizeBilinear(u8, smallU8, o); }; });
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "SIMD vs scalar reference:\n";
+    if (!validate()) {
+        std::cout << "SIMD results differ from the scalar reference\n";
+        return 1;
+    }
+
+    std::vector<ImageU8> rgb = {makeImage(640, 480), makeImage(640, 480), makeImage(640, 480)};
+    auto result = imageProcessing(rgb, ExecOptions{int(std::thread::hardware_concurrency()), true});
+    std::cout << "\nimageProcessing: 3 planes 640x480 -> " << result.size() << " planes "
+              << result[0].width << "x" << result[0].height << '\n';
+
+    int width = argc > 1 ? std::atoi(argv[1]) : 3840;
+    int height = argc > 2 ? std::atoi(argv[2]) : 2160;
+    benchmark(width, height);
+}
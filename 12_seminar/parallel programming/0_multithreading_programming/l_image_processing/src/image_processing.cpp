@@ -0,0 +1,430 @@
+#include "image_processing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#else
+#define HAVE_SSE2 0
+#endif
+
+namespace {
+
+int clampInt(int v, int lo, int hi) { return std::min(std::max(v, lo), hi); }
+
+// Hand out strips [y0, y1) of `height` rows to `threads` threads. Strips are
+// claimed dynamically, so a slow strip does not hold back a whole thread's share.
+template<class Fn>
+void forEachStrip(int height, int stripRows, int threads, Fn fn) {
+    int numStrips = (height + stripRows - 1) / stripRows;
+    std::atomic<int> next{0};
+    auto worker = [&] {
+        for (int s; (s = next.fetch_add(1)) < numStrips;)
+            fn(s * stripRows, std::min(height, (s + 1) * stripRows));
+    };
+    threads = clampInt(threads, 1, std::max(1, numStrips));
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i)
+        helpers.emplace_back(worker);
+    worker();
+    for (auto& t : helpers) t.join();
+}
+
+// Output rows per strip so that the strip's intermediate rows (plus the
+// 2 * halo extra rows) take about 256 KiB, i.e. stay in L2 between the passes
+int stripRowsFor(int width, size_t bytesPerPixel, int halo) {
+    size_t rowBytes = size_t(std::max(1, width)) * bytesPerPixel;
+    int rows = static_cast<int>((256 * 1024) / rowBytes) - 2 * halo;
+    return std::max(8, rows);
+}
+
+// Copy a row into `out` with `r` replicated pixels on both sides
+template<class T>
+void padRow(const T* in, int width, int r, T* out) {
+    std::fill(out, out + r, in[0]);
+    std::copy(in, in + width, out + r);
+    std::fill(out + r + width, out + 2 * r + width, in[width - 1]);
+}
+
+// Generic cache-tiled separable filter: for every strip, the horizontal pass
+// writes (rows + 2r) intermediate rows into a strip-local buffer, and the
+// vertical pass reads them back while they are still in cache.
+template<class TIn, class TMid, class TOut, class Horizontal, class Vertical>
+void separable(const Image<TIn>& src, Image<TOut>& dst, int r, const ExecOptions& options,
+               Horizontal horizontal, Vertical vertical) {
+    Image<TOut> out(src.width, src.height);  // not dst: it may be src
+    if (src.width == 0 || src.height == 0) {  // nothing to pad from
+        std::swap(dst, out);
+        return;
+    }
+    const int width = src.width;
+    int stripRows = stripRowsFor(width, sizeof(TMid), r);
+    forEachStrip(src.height, stripRows, options.threads, [&](int y0, int y1) {
+        int rows = (y1 - y0) + 2 * r;
+        std::vector<TIn> padded(width + 2 * r);
+        std::vector<TMid> mid(size_t(rows) * width);
+        for (int i = 0; i < rows; ++i) {
+            int sy = clampInt(y0 - r + i, 0, src.height - 1);
+            padRow(src.row(sy), width, r, padded.data());
+            horizontal(padded.data(), mid.data() + size_t(i) * width, width);
+        }
+        std::vector<const TMid*> window(2 * r + 1);
+        for (int y = y0; y < y1; ++y) {
+            for (int k = 0; k <= 2 * r; ++k)
+                window[k] = mid.data() + size_t(y - y0 + k) * width;
+            vertical(window.data(), out.row(y), width);
+        }
+    });
+    std::swap(dst, out);
+}
+
+// ---------------------------------------------------------------- Gaussian 8-bit
+// Horizontal: a + e + 4(b + d) + 6c <= 4080, kept as uint16
+void gaussH_u8(const uint8_t* p, uint16_t* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 8 <= width; x += 8) {
+            auto load = [&](int k) {
+                return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + x + k)), zero);
+            };
+            __m128i a = load(0), b = load(1), c = load(2), d = load(3), e = load(4);
+            __m128i s = _mm_add_epi16(a, e);
+            s = _mm_add_epi16(s, _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+            s = _mm_add_epi16(s, _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), s);
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = uint16_t(p[x] + p[x + 4] + 4 * (p[x + 1] + p[x + 3]) + 6 * p[x + 2]);
+}
+
+// Vertical: same weights, sum <= 65280 still fits uint16; (v + 128) >> 8 divides by 256
+void gaussV_u8(const uint16_t* const* r, uint8_t* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128i round = _mm_set1_epi16(128);
+        for (; x + 8 <= width; x += 8) {
+            auto load = [&](int k) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(r[k] + x)); };
+            __m128i a = load(0), b = load(1), c = load(2), d = load(3), e = load(4);
+            __m128i s = _mm_add_epi16(a, e);
+            s = _mm_add_epi16(s, _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+            s = _mm_add_epi16(s, _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+            s = _mm_srli_epi16(_mm_add_epi16(s, round), 8);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(s, s));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        unsigned v = r[0][x] + r[4][x] + 4u * (r[1][x] + r[3][x]) + 6u * r[2][x];
+        out[x] = uint8_t((v + 128) >> 8);
+    }
+}
+
+// ---------------------------------------------------------------- Gaussian float
+// SIMD and scalar use the same operation order, so results match exactly
+// (unless the compiler contracts the scalar code into FMAs)
+void gaussH_f32(const float* p, float* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128 four = _mm_set1_ps(4.0f), six = _mm_set1_ps(6.0f);
+        for (; x + 4 <= width; x += 4) {
+            __m128 a = _mm_loadu_ps(p + x), b = _mm_loadu_ps(p + x + 1), c = _mm_loadu_ps(p + x + 2);
+            __m128 d = _mm_loadu_ps(p + x + 3), e = _mm_loadu_ps(p + x + 4);
+            __m128 s = _mm_add_ps(_mm_add_ps(a, e), _mm_mul_ps(four, _mm_add_ps(b, d)));
+            _mm_storeu_ps(out + x, _mm_add_ps(s, _mm_mul_ps(six, c)));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = ((p[x] + p[x + 4]) + 4.0f * (p[x + 1] + p[x + 3])) + 6.0f * p[x + 2];
+}
+
+void gaussV_f32(const float* const* r, float* out, int width, bool simd) {
+    const float norm = 1.0f / 256.0f;
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128 four = _mm_set1_ps(4.0f), six = _mm_set1_ps(6.0f), n = _mm_set1_ps(norm);
+        for (; x + 4 <= width; x += 4) {
+            __m128 a = _mm_loadu_ps(r[0] + x), b = _mm_loadu_ps(r[1] + x), c = _mm_loadu_ps(r[2] + x);
+            __m128 d = _mm_loadu_ps(r[3] + x), e = _mm_loadu_ps(r[4] + x);
+            __m128 s = _mm_add_ps(_mm_add_ps(a, e), _mm_mul_ps(four, _mm_add_ps(b, d)));
+            s = _mm_add_ps(s, _mm_mul_ps(six, c));
+            _mm_storeu_ps(out + x, _mm_mul_ps(s, n));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = (((r[0][x] + r[4][x]) + 4.0f * (r[1][x] + r[3][x])) + 6.0f * r[2][x]) * norm;
+}
+
+// ---------------------------------------------------------------- box float
+void boxH_f32(const float* p, float* out, int width, int n, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        for (; x + 4 <= width; x += 4) {
+            __m128 s = _mm_loadu_ps(p + x);
+            for (int k = 1; k < n; ++k) s = _mm_add_ps(s, _mm_loadu_ps(p + x + k));
+            _mm_storeu_ps(out + x, s);
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        float s = p[x];
+        for (int k = 1; k < n; ++k) s += p[x + k];
+        out[x] = s;
+    }
+}
+
+void boxV_f32(const float* const* r, float* out, int width, int n, bool simd) {
+    const float norm = 1.0f / float(n * n);
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128 nv = _mm_set1_ps(norm);
+        for (; x + 4 <= width; x += 4) {
+            __m128 s = _mm_loadu_ps(r[0] + x);
+            for (int k = 1; k < n; ++k) s = _mm_add_ps(s, _mm_loadu_ps(r[k] + x));
+            _mm_storeu_ps(out + x, _mm_mul_ps(s, nv));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        float s = r[0][x];
+        for (int k = 1; k < n; ++k) s += r[k][x];
+        out[x] = s * norm;
+    }
+}
+
+// ---------------------------------------------------------------- Sobel
+// a, m, b: rows above, middle, below, each padded by one pixel on both sides
+void sobelRow_u8(const uint8_t* a, const uint8_t* m, const uint8_t* b, uint8_t* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128i zero = _mm_setzero_si128();
+        auto load = [&](const uint8_t* p) {
+            return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+        };
+        auto absv = [&](__m128i v) { return _mm_max_epi16(v, _mm_sub_epi16(zero, v)); };
+        for (; x + 8 <= width; x += 8) {
+            __m128i a0 = load(a + x), a1 = load(a + x + 1), a2 = load(a + x + 2);
+            __m128i m0 = load(m + x), m2 = load(m + x + 2);
+            __m128i b0 = load(b + x), b1 = load(b + x + 1), b2 = load(b + x + 2);
+            __m128i gx = _mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(b2, b0));
+            gx = _mm_add_epi16(gx, _mm_slli_epi16(_mm_sub_epi16(m2, m0), 1));
+            __m128i gy = _mm_add_epi16(_mm_sub_epi16(b0, a0), _mm_sub_epi16(b2, a2));
+            gy = _mm_add_epi16(gy, _mm_slli_epi16(_mm_sub_epi16(b1, a1), 1));
+            __m128i mag = _mm_add_epi16(absv(gx), absv(gy));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(mag, mag));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        int gx = (a[x + 2] - a[x]) + (b[x + 2] - b[x]) + 2 * (m[x + 2] - m[x]);
+        int gy = (b[x] - a[x]) + (b[x + 2] - a[x + 2]) + 2 * (b[x + 1] - a[x + 1]);
+        out[x] = uint8_t(std::min(255, std::abs(gx) + std::abs(gy)));
+    }
+}
+
+void sobelRow_f32(const float* a, const float* m, const float* b, float* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128 sign = _mm_set1_ps(-0.0f), two = _mm_set1_ps(2.0f);
+        for (; x + 4 <= width; x += 4) {
+            __m128 a0 = _mm_loadu_ps(a + x), a1 = _mm_loadu_ps(a + x + 1), a2 = _mm_loadu_ps(a + x + 2);
+            __m128 m0 = _mm_loadu_ps(m + x), m2 = _mm_loadu_ps(m + x + 2);
+            __m128 b0 = _mm_loadu_ps(b + x), b1 = _mm_loadu_ps(b + x + 1), b2 = _mm_loadu_ps(b + x + 2);
+            __m128 gx = _mm_add_ps(_mm_add_ps(_mm_sub_ps(a2, a0), _mm_sub_ps(b2, b0)),
+                                   _mm_mul_ps(two, _mm_sub_ps(m2, m0)));
+            __m128 gy = _mm_add_ps(_mm_add_ps(_mm_sub_ps(b0, a0), _mm_sub_ps(b2, a2)),
+                                   _mm_mul_ps(two, _mm_sub_ps(b1, a1)));
+            _mm_storeu_ps(out + x, _mm_add_ps(_mm_andnot_ps(sign, gx), _mm_andnot_ps(sign, gy)));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        float gx = ((a[x + 2] - a[x]) + (b[x + 2] - b[x])) + 2.0f * (m[x + 2] - m[x]);
+        float gy = ((b[x] - a[x]) + (b[x + 2] - a[x + 2])) + 2.0f * (b[x + 1] - a[x + 1]);
+        out[x] = std::fabs(gx) + std::fabs(gy);
+    }
+}
+
+template<class T, class RowFn>
+void sobelImpl(const Image<T>& src, Image<T>& dst, const ExecOptions& options, RowFn rowFn) {
+    Image<T> out(src.width, src.height);  // not dst: it may be src
+    if (src.width == 0 || src.height == 0) {  // nothing to pad from
+        std::swap(dst, out);
+        return;
+    }
+    const int width = src.width;
+    forEachStrip(src.height, stripRowsFor(width + 2, sizeof(T), 1), options.threads, [&](int y0, int y1) {
+        // pad the strip's rows (plus one above and below) once, then slide a 3-row window
+        int rows = (y1 - y0) + 2;
+        size_t stride = width + 2;
+        std::vector<T> padded(rows * stride);
+        for (int i = 0; i < rows; ++i)
+            padRow(src.row(clampInt(y0 - 1 + i, 0, src.height - 1)), width, 1, padded.data() + i * stride);
+        for (int y = y0; y < y1; ++y) {
+            const T* a = padded.data() + (y - y0) * stride;
+            rowFn(a, a + stride, a + 2 * stride, out.row(y), width, options.simd);
+        }
+    });
+    std::swap(dst, out);
+}
+
+// ---------------------------------------------------------------- resize
+// Source coordinate of each destination pixel (pixel centres aligned)
+struct Tap {
+    int i0, i1;
+    float f;  // weight of i1
+};
+
+std::vector<Tap> taps(int srcSize, int dstSize) {
+    std::vector<Tap> t(dstSize);
+    double scale = double(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; ++i) {
+        double s = std::max(0.0, (i + 0.5) * scale - 0.5);
+        int i0 = std::min(int(s), srcSize - 1);
+        t[i] = {i0, std::min(i0 + 1, srcSize - 1), float(s - i0)};
+    }
+    return t;
+}
+
+// Vertical blend of two horizontally interpolated rows: (h0 * w0 + h1 * w1 + 2^15) >> 16,
+// with h <= 255 * 256 and w0 + w1 = 256. The 32-bit products are rebuilt from
+// SSE2's low and high 16-bit halves.
+void resizeV_u8(const uint16_t* h0, const uint16_t* h1, unsigned w1, uint8_t* out, int width, bool simd) {
+    unsigned w0 = 256 - w1;
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128i vw0 = _mm_set1_epi16(short(w0)), vw1 = _mm_set1_epi16(short(w1));
+        const __m128i round = _mm_set1_epi32(1 << 15);
+        for (; x + 8 <= width; x += 8) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h0 + x));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h1 + x));
+            __m128i alo = _mm_mullo_epi16(a, vw0), ahi = _mm_mulhi_epu16(a, vw0);
+            __m128i blo = _mm_mullo_epi16(b, vw1), bhi = _mm_mulhi_epu16(b, vw1);
+            __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(alo, ahi), _mm_unpacklo_epi16(blo, bhi));
+            __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(alo, ahi), _mm_unpackhi_epi16(blo, bhi));
+            lo = _mm_srli_epi32(_mm_add_epi32(lo, round), 16);
+            hi = _mm_srli_epi32(_mm_add_epi32(hi, round), 16);
+            __m128i v = _mm_packs_epi32(lo, hi);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(v, v));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = uint8_t((h0[x] * w0 + h1[x] * w1 + (1u << 15)) >> 16);
+}
+
+void resizeV_f32(const float* h0, const float* h1, float f, float* out, int width, bool simd) {
+    int x = 0;
+#if HAVE_SSE2
+    if (simd) {
+        const __m128 vf = _mm_set1_ps(f);
+        for (; x + 4 <= width; x += 4) {
+            __m128 a = _mm_loadu_ps(h0 + x), b = _mm_loadu_ps(h1 + x);
+            _mm_storeu_ps(out + x, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vf)));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        out[x] = h0[x] + (h1[x] - h0[x]) * f;
+}
+
+// Horizontal interpolation is a gather, so it stays scalar; each source row
+// is interpolated once per strip and kept in a two-row cache
+template<class T, class TMid, class Horizontal, class Vertical>
+void resizeImpl(const Image<T>& src, Image<T>& dst, const ExecOptions& options,
+                Horizontal horizontal, Vertical vertical) {
+    Image<T> out(dst.width, dst.height);  // not dst: it may be src
+    if (src.width == 0 || src.height == 0 || out.width == 0 || out.height == 0) {  // nothing to sample
+        std::swap(dst, out);
+        return;
+    }
+    std::vector<Tap> tx = taps(src.width, out.width), ty = taps(src.height, out.height);
+    forEachStrip(out.height, 64, options.threads, [&](int y0, int y1) {
+        std::vector<TMid> buffer[2] = {std::vector<TMid>(out.width), std::vector<TMid>(out.width)};
+        int tag[2] = {-1, -1};
+        auto fetch = [&](int sy, int keep) -> const TMid* {
+            for (int s = 0; s < 2; ++s)
+                if (tag[s] == sy) return buffer[s].data();
+            int slot = tag[0] == keep ? 1 : 0;
+            horizontal(src.row(sy), tx, buffer[slot].data());
+            tag[slot] = sy;
+            return buffer[slot].data();
+        };
+        for (int y = y0; y < y1; ++y) {
+            const Tap& t = ty[y];
+            const TMid* h0 = fetch(t.i0, t.i1);
+            const TMid* h1 = fetch(t.i1, t.i0);
+            vertical(h0, h1, t.f, out.row(y), out.width, options.simd);
+        }
+    });
+    std::swap(dst, out);
+}
+
+} // namespace
+
+void gaussianBlur5(const ImageU8& src, ImageU8& dst, const ExecOptions& options) {
+    separable<uint8_t, uint16_t>(src, dst, 2, options,
+        [&](const uint8_t* p, uint16_t* out, int w) { gaussH_u8(p, out, w, options.simd); },
+        [&](const uint16_t* const* r, uint8_t* out, int w) { gaussV_u8(r, out, w, options.simd); });
+}
+
+void gaussianBlur5(const ImageF32& src, ImageF32& dst, const ExecOptions& options) {
+    separable<float, float>(src, dst, 2, options,
+        [&](const float* p, float* out, int w) { gaussH_f32(p, out, w, options.simd); },
+        [&](const float* const* r, float* out, int w) { gaussV_f32(r, out, w, options.simd); });
+}
+
+void boxBlur(const ImageF32& src, ImageF32& dst, int radius, const ExecOptions& options) {
+    int n = 2 * radius + 1;
+    separable<float, float>(src, dst, radius, options,
+        [&](const float* p, float* out, int w) { boxH_f32(p, out, w, n, options.simd); },
+        [&](const float* const* r, float* out, int w) { boxV_f32(r, out, w, n, options.simd); });
+}
+
+void sobel(const ImageU8& src, ImageU8& dst, const ExecOptions& options) {
+    sobelImpl(src, dst, options, sobelRow_u8);
+}
+
+void sobel(const ImageF32& src, ImageF32& dst, const ExecOptions& options) {
+    sobelImpl(src, dst, options, sobelRow_f32);
+}
+
+void resizeBilinear(const ImageU8& src, ImageU8& dst, const ExecOptions& options) {
+    resizeImpl<uint8_t, uint16_t>(src, dst, options,
+        [](const uint8_t* row, const std::vector<Tap>& tx, uint16_t* out) {
+            for (size_t x = 0; x < tx.size(); ++x) {
+                unsigned w1 = unsigned(tx[x].f * 256.0f + 0.5f);
+                out[x] = uint16_t(row[tx[x].i0] * (256 - w1) + row[tx[x].i1] * w1);
+            }
+        },
+        [](const uint16_t* h0, const uint16_t* h1, float f, uint8_t* out, int w, bool simd) {
+            resizeV_u8(h0, h1, unsigned(f * 256.0f + 0.5f), out, w, simd);
+        });
+}
+
+void resizeBilinear(const ImageF32& src, ImageF32& dst, const ExecOptions& options) {
+    resizeImpl<float, float>(src, dst, options,
+        [](const float* row, const std::vector<Tap>& tx, float* out) {
+            for (size_t x = 0; x < tx.size(); ++x)
+                out[x] = row[tx[x].i0] + (row[tx[x].i1] - row[tx[x].i0]) * tx[x].f;
+        },
+        resizeV_f32);
+}
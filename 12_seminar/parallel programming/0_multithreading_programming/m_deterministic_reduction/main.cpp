@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#else
+#define HAVE_SSE2 0
+#endif
+
+enum class Summation {
+    Plain,    // fixed-shape tree of plain additions
+    Neumaier  // every addition carries a compensation term
+};
+
+struct ReduceOptions {
+    int threads = 1;
+    Summation summation = Summation::Plain;
+    bool simd = true;  // false: scalar loops with the same lane structure (same result)
+};
+
+// The shape of the reduction depends only on n, never on the thread count:
+// - elements are cut into blocks of kBlock,
+// - inside a block, element i goes to accumulator lane (i % kLanes),
+//   lanes are combined as ((0+1)+(2+3))+((4+5)+(6+7)),
+// - block results are combined by a pairwise tree over the block index.
+// Threads only decide *who* computes a block, not how it is computed.
+constexpr size_t kBlock = 4096;
+constexpr int kLanes = 8;
+
+namespace detail {
+
+// s += x, accumulating the rounding error of the addition into c
+inline void neumaierAdd(double& s, double& c, double x) {
+    double t = s + x;
+    if (std::fabs(s) >= std::fabs(x))
+        c += (s - t) + x;
+    else
+        c += (x - t) + s;
+    s = t;
+}
+
+struct Partial {
+    double sum = 0;
+    double comp = 0;
+};
+
+// One block: Term(i) yields the i-th term (x[i] or x[i] * y[i])
+template<class Term, class TermSimd>
+Partial reduceBlock(size_t begin, size_t end, Summation summation, bool simd, Term term, TermSimd termSimd) {
+    alignas(16) double s[kLanes] = {}, c[kLanes] = {};
+    size_t i = begin;
+#if HAVE_SSE2
+    if (simd) {
+        // four independent accumulators, unrolled by hand: the adds of one
+        // step do not wait for each other, and -O2 keeps them in registers
+        __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+        __m128d c0 = _mm_setzero_pd(), c1 = c0, c2 = c0, c3 = c0;
+        if (summation == Summation::Plain) {
+            for (; i + kLanes <= end; i += kLanes) {
+                a0 = _mm_add_pd(a0, termSimd(i));
+                a1 = _mm_add_pd(a1, termSimd(i + 2));
+                a2 = _mm_add_pd(a2, termSimd(i + 4));
+                a3 = _mm_add_pd(a3, termSimd(i + 6));
+            }
+        } else {
+            const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+            auto step = [absMask](__m128d& acc, __m128d& cmp, __m128d x) {
+                __m128d t = _mm_add_pd(acc, x);
+                // big/small = |s| >= |x| ? (s, x) : (x, s), selected without branches
+                __m128d sBigger = _mm_cmpge_pd(_mm_and_pd(acc, absMask), _mm_and_pd(x, absMask));
+                __m128d big = _mm_or_pd(_mm_and_pd(sBigger, acc), _mm_andnot_pd(sBigger, x));
+                __m128d small = _mm_or_pd(_mm_and_pd(sBigger, x), _mm_andnot_pd(sBigger, acc));
+                cmp = _mm_add_pd(cmp, _mm_add_pd(_mm_sub_pd(big, t), small));
+                acc = t;
+            };
+            for (; i + kLanes <= end; i += kLanes) {
+                step(a0, c0, termSimd(i));
+                step(a1, c1, termSimd(i + 2));
+                step(a2, c2, termSimd(i + 4));
+                step(a3, c3, termSimd(i + 6));
+            }
+        }
+        _mm_store_pd(s, a0);
+        _mm_store_pd(s + 2, a1);
+        _mm_store_pd(s + 4, a2);
+        _mm_store_pd(s + 6, a3);
+        _mm_store_pd(c, c0);
+        _mm_store_pd(c + 2, c1);
+        _mm_store_pd(c + 4, c2);
+        _mm_store_pd(c + 6, c3);
+    }
+#endif
+    // scalar reference, and the tail of the last block
+    for (; i < end; ++i) {
+        int lane = int((i - begin) % kLanes);
+        if (summation == Summation::Plain)
+            s[lane] += term(i);
+        else
+            neumaierAdd(s[lane], c[lane], term(i));
+    }
+
+    Partial p;
+    if (summation == Summation::Plain) {
+        p.sum = ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7]));
+    } else {
+        p.sum = s[0];
+        p.comp = c[0];
+        for (int k = 1; k < kLanes; ++k) {
+            neumaierAdd(p.sum, p.comp, s[k]);
+            p.comp += c[k];
+        }
+    }
+    return p;
+}
+
+double pairwise(const std::vector<Partial>& p, size_t lo, size_t hi) {
+    if (hi - lo == 1) return p[lo].sum;
+    size_t mid = lo + (hi - lo) / 2;
+    return pairwise(p, lo, mid) + pairwise(p, mid, hi);
+}
+
+template<class Term, class TermSimd>
+double reduce(size_t n, const ReduceOptions& options, Term term, TermSimd termSimd) {
+    if (n == 0) return 0.0;
+    size_t numBlocks = (n + kBlock - 1) / kBlock;
+    std::vector<Partial> partials(numBlocks);
+
+    // threads claim runs of blocks; each result lands in its block's slot
+    constexpr size_t kClaim = 16;
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t first; (first = next.fetch_add(kClaim)) < numBlocks;)
+            for (size_t b = first; b < std::min(numBlocks, first + kClaim); ++b)
+                partials[b] = reduceBlock(b * kBlock, std::min(n, (b + 1) * kBlock), options.summation,
+                                          options.simd, term, termSimd);
+    };
+    int threads = int(std::clamp<size_t>(options.threads, 1, (numBlocks + kClaim - 1) / kClaim));
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < threads; ++t) helpers.emplace_back(worker);
+    worker();
+    for (auto& t : helpers) t.join();
+
+    if (options.summation == Summation::Plain)
+        return pairwise(partials, 0, numBlocks);
+    Partial total = partials[0];
+    for (size_t b = 1; b < numBlocks; ++b) {
+        neumaierAdd(total.sum, total.comp, partials[b].sum);
+        total.comp += partials[b].comp;
+    }
+    return total.sum + total.comp;
+}
+
+} // namespace detail
+
+// sum of x[0..n)
+double sum(const double* x, size_t n, const ReduceOptions& options = {}) {
+    return detail::reduce(n, options, [x](size_t i) { return x[i]; },
+#if HAVE_SSE2
+        [x](size_t i) { return _mm_loadu_pd(x + i); }
+#else
+        nullptr
+#endif
+    );
+}
+
+// sum of x[i] * y[i]
+double dot(const double* x, const double* y, size_t n, const ReduceOptions& options = {}) {
+    return detail::reduce(n, options, [x, y](size_t i) { return x[i] * y[i]; },
+#if HAVE_SSE2
+        [x, y](size_t i) { return _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)); }
+#else
+        nullptr
+#endif
+    );
+}
+
+// Euclidean norm, sqrt(dot(x, x)) (no rescaling: squares must not overflow)
+double norm2(const double* x, size_t n, const ReduceOptions& options = {}) {
+    return std::sqrt(dot(x, x, n, options));
+}
+
+// The real work behind the old sleep stub: cosine similarity of two signals
+double scientificComputation(const std::vector<double>& a, const std::vector<double>& b,
+                             const ReduceOptions& options) {
+    return dot(a.data(), b.data(), a.size(), options) /
+           (norm2(a.data(), a.size(), options) * norm2(b.data(), b.size(), options));
+}
+
+// ------------------------------------------------------------ baselines
+double serialLoop(const double* x, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; ++i) s += x[i];
+    return s;
+}
+
+// The usual parallel sum: one contiguous chunk per thread. The tree shape
+// follows the thread count, so does the rounding.
+double naiveParallel(const double* x, size_t n, int threads) {
+    std::vector<double> partial(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back([&, t] { partial[t] = serialLoop(x + n * t / threads, n * (t + 1) / threads - n * t / threads); });
+    for (auto& th : pool) th.join();
+    return serialLoop(partial.data(), threads);
+}
+
+// Accurate reference: compensated summation in long double
+long double reference(const double* x, size_t n) {
+    long double s = 0, c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        long double t = s + x[i];
+        c += std::fabs(s) >= std::fabs(x[i]) ? (s - t) + x[i] : (x[i] - t) + s;
+        s = t;
+    }
+    return s + c;
+}
+
+// ------------------------------------------------------------ benchmark
+template<class F>
+double seconds(F f) {
+    f(); // warm-up
+    int runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        f();
+        ++runs;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.3);
+    return elapsed.count() / runs;
+}
+
+std::string bits(double v) {
+    uint64_t u;
+    std::memcpy(&u, &v, sizeof u);
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%016llx", static_cast<unsigned long long>(u));
+    return buf;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (size_t(1) << 23);
+    int hw = std::max(1u, std::thread::hardware_concurrency());
+
+    // Ill-conditioned data: magnitudes spread over 16 decades, both signs
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0), exponent(-8.0, 8.0);
+    std::vector<double> x(n);
+    for (auto& v : x) v = mantissa(rng) * std::pow(10.0, exponent(rng));
+    long double exact = reference(x.data(), n);
+    auto relErr = [&](double v) { return double(std::fabs((v - exact) / exact)); };
+
+    std::vector<int> threadCounts = {1, 2, 3, 4};
+    if (hw > 4) threadCounts.push_back(hw);
+
+    std::cout << "n = " << n << ", relative error vs. long double reference, and result bits per thread count\n";
+    std::cout << "naive parallel (chunk per thread):\n";
+    for (int t : threadCounts) {
+        double v = naiveParallel(x.data(), n, t);
+        std::cout << "  threads " << t << ": " << bits(v) << "  rel.err " << relErr(v) << '\n';
+    }
+    for (Summation s : {Summation::Plain, Summation::Neumaier}) {
+        std::cout << (s == Summation::Plain ? "deterministic, plain:\n" : "deterministic, Neumaier:\n");
+        for (int t : threadCounts)
+            for (bool simd : {true, false}) {
+                double v = sum(x.data(), n, ReduceOptions{t, s, simd});
+                std::cout << "  threads " << t << (simd ? " simd  : " : " scalar: ") << bits(v)
+                          << "  rel.err " << relErr(v) << '\n';
+            }
+    }
+    std::cout << "serial loop: rel.err " << relErr(serialLoop(x.data(), n)) << "\n\n";
+
+    double gb = n * sizeof(double) / 1e9;
+    volatile double sink = 0;
+    std::cout << "Throughput (GB/s read):\n";
+    std::cout << "  serial loop              " << gb / seconds([&] { sink = serialLoop(x.data(), n); }) << '\n';
+    for (Summation s : {Summation::Plain, Summation::Neumaier})
+        for (int t : threadCounts) {
+            ReduceOptions o{t, s, true};
+            std::cout << "  " << (s == Summation::Plain ? "plain    " : "neumaier ") << " threads " << t << "       "
+                      << gb / seconds([&] { sink = sum(x.data(), n, o); }) << '\n';
+        }
+    std::cout << "  neumaier threads 1 scalar "
+              << gb / seconds([&] { sink = sum(x.data(), n, ReduceOptions{1, Summation::Neumaier, false}); }) << '\n';
+
+    std::vector<double> y(x.rbegin(), x.rend());
+    std::cout << "\nscientificComputation (cosine similarity): "
+              << scientificComputation(x, y, ReduceOptions{hw, Summation::Neumaier, true}) << '\n';
+    (void)sink;
+}